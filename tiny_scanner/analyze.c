@@ -1,81 +1,170 @@
 /****************************************************/
 /* File: analyze.c                                  */
 /* Semantic analyzer implementation                 */
-/* for the TINY compiler                            */
+/* for the C- compiler                              */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <pthread.h>
 #include "globals.h"
+#include "intern.h"
 #include "symtab.h"
+#include "srcloc.h"
+#include "util.h"
+#include "arena.h"
+#include "compiler.h"
+#include "walk.h"
 #include "analyze.h"
 
-/* counter for variable memory locations */
-static int location = 0;
+/* cc->location counts the memory locations of the
+ * globals, from 0 up; cc->frameOffset the frame
+ * offsets of the parameters and locals of the
+ * function being analyzed, from FRAMESTART down.
+ * An array takes as many locations as it has
+ * elements, its offset being that of element 0
+ */
+#define FRAMESTART (-2)
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
- * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+/* The walks keep in the frame of each node
+ * (walk.h) the id of the symbol it declares or
+ * names in local[0], -1 for none; a compound
+ * statement keeps whether it opened a scope in
+ * local[0] and the frame offset it started at in
+ * local[1]
  */
-static void traverse( TreeNode * t,
-               void (* preProc) (TreeNode *),
-               void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
+
+/* growInts makes room for element n of the array p
+   of *cap ints, doubling it */
+static int * growInts( int * p, int * cap, int n )
+{ if (n >= *cap)
+  { *cap = *cap ? 2 * *cap : 1024;
+    if ((p = realloc(p,*cap * sizeof(int))) == NULL)
+    { fprintf(stderr,"Out of memory for the symbol table\n");
+      exit(1);
     }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
   }
+  return p;
+}
+
+static void typeError(Compiler * cc, TreeNode * t, char * message)
+{ outPrintf(cc->listing,"Type error at line %d: %s\n",locLine(cc,t->loc),message);
+  cc->Error = TRUE;
+}
+
+static void nameError(Compiler * cc, TreeNode * t, Atom name, char * message)
+{ outPrintf(cc->listing,"Declaration error at line %d: %s %s\n",
+            locLine(cc,t->loc),name,message);
+  cc->Error = TRUE;
 }
 
-/* nullProc is a do-nothing procedure to 
- * generate preorder-only or postorder-only
- * traversals from traverse
+/* named tells whether t declares or names a symbol */
+static int named( TreeNode * t )
+{ if (t->nodekind == DeclK) return TRUE;
+  return t->nodekind == ExpK && (t->kind.exp == IdK
+         || t->kind.exp == ArrIdK || t->kind.exp == CallK);
+}
+
+/* isArray tells whether s is an array */
+static int isArray( Symbol * s )
+{ return s->kind == ArrVarK || s->kind == ArrParamK;
+}
+
+/* declareBuiltins declares int input(void) and
+ * void output(int x) in the global scope
  */
-static void nullProc(TreeNode * t)
-{ if (t==NULL) return;
-  else return;
+static void declareBuiltins( Compiler * cc )
+{ TreeNode * input = newDeclNode(cc,FuncK,0);
+  TreeNode * output = newDeclNode(cc,FuncK,0);
+  TreeNode * x = newDeclNode(cc,ParamK,0);
+  x->attr.name = intern(cc,"x",1);
+  output->child[1] = x;
+  input->attr.name = intern(cc,"input",5);
+  output->attr.name = intern(cc,"output",6);
+  st_declare(cc,input->attr.name,FuncK,Integer,-1,0,input);
+  st_declare(cc,output->attr.name,FuncK,Void,-1,0,output);
 }
 
-/* Procedure insertNode inserts 
- * identifiers stored in t into 
- * the symbol table 
+/* declare declares the name the declaration t
+ * declares, giving it its memory location or frame
+ * offset, and returns its symbol, or NULL if the
+ * name is already declared in the current scope
  */
-static void insertNode( TreeNode * t)
-{ switch (t->nodekind)
-  { case StmtK:
-      switch (t->kind.stmt)
-      { case AssignK:
-        case ReadK:
-          if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
-          else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
-          break;
-        default:
-          break;
+static Symbol * declare( Compiler * cc, TreeNode * t )
+{ Atom name = t->attr.name;
+  ExpType type = t->child[0] != NULL && t->child[0]->attr.type == VOID
+                 ? Void : Integer;
+  int size = t->kind.decl == ArrVarK ? t->attr.arrAttr.size : 1;
+  int offset;
+  Symbol * s;
+  if (type == Void && t->kind.decl != FuncK)
+  { nameError(cc,t,name,"is declared void");
+    type = Integer;
+  }
+  if (t->kind.decl == FuncK) offset = 0;
+  else if (st_depth(cc) == 0)
+  { offset = cc->location;
+    cc->location += size;
+  }
+  else
+  { cc->frameOffset -= size;
+    offset = cc->frameOffset + 1;
+  }
+  t->type = type;
+  t->sym = s = st_declare(cc,name,t->kind.decl,type,
+                          t->kind.decl == ArrVarK ? size : -1,offset,t);
+  if (s == NULL)
+    nameError(cc,t,name,"is already declared in this scope");
+  else st_reference(cc,s,t->loc);
+  return s;
+}
+
+/* openFunction opens the scope of the parameters
+ * and body of the function s, NULL if its name was
+ * taken
+ */
+static void openFunction( Compiler * cc, Symbol * s )
+{ cc->function = s;
+  cc->funcBody = TRUE;
+  cc->frameOffset = FRAMESTART + 1;
+  st_enterScope(cc);
+}
+
+/* Procedure declareNode declares the names t
+ * declares and resolves those it uses, opening a
+ * scope for each function and compound statement,
+ * and puts the symbol it finds in t->sym and in
+ * the frame of t; the preorder hook of both analyze
+ * and buildSymtab
+ */
+static void declareNode( Compiler * cc, TreeNode * t )
+{ WalkFrame * f = walkFrame(cc,0);
+  Symbol * s = NULL;
+  f->local[0] = -1;
+  switch (t->nodekind)
+  { case DeclK:
+      s = declare(cc,t);
+      if (s != NULL) f->local[0] = s->id;
+      if (t->kind.decl == FuncK) openFunction(cc,s);
+      break;
+    case StmtK:
+      if (t->kind.stmt == CompK)
+      { /* the body of a function shares the scope of
+           its parameters */
+        f->local[0] = !cc->funcBody;
+        f->local[1] = cc->frameOffset;
+        if (!cc->funcBody) st_enterScope(cc);
+        cc->funcBody = FALSE;
       }
       break;
     case ExpK:
-      switch (t->kind.exp)
-      { case IdK:
-          if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
-          else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
-          break;
-        default:
-          break;
+      if (named(t))
+      { t->sym = s = st_find(cc,t->attr.name);
+        if (s == NULL) nameError(cc,t,t->attr.name,"is not declared");
+        else
+        { st_reference(cc,s,t->loc);
+          f->local[0] = s->id;
+        }
       }
       break;
     default:
@@ -83,41 +172,88 @@ static void insertNode( TreeNode * t)
   }
 }
 
-/* Function buildSymtab constructs the symbol 
- * table by preorder traversal of the syntax tree
+/* Procedure closeNode closes the scope t opened,
+ * if any
  */
-void buildSymtab(TreeNode * syntaxTree)
-{ traverse(syntaxTree,insertNode,nullProc);
-  if (TraceAnalyze)
-  { fprintf(listing,"\nSymbol table:\n\n");
-    printSymTab(listing);
+static void closeNode( Compiler * cc, TreeNode * t )
+{ WalkFrame * f = walkFrame(cc,0);
+  if (t->nodekind == DeclK && t->kind.decl == FuncK)
+  { st_exitScope(cc);
+    cc->function = NULL;
+  }
+  else if (t->nodekind == StmtK && t->kind.stmt == CompK)
+  { if (f->local[0]) st_exitScope(cc);
+    cc->frameOffset = f->local[1];
   }
 }
 
-static void typeError(TreeNode * t, char * message)
-{ fprintf(listing,"Type error at line %d: %s\n",t->lineno,message);
-  Error = TRUE;
+/* checkCall checks the arguments of the call t to
+ * the function s against its parameters
+ */
+static void checkCall( Compiler * cc, TreeNode * t, Symbol * s )
+{ TreeNode * arg = t->child[0];
+  TreeNode * param = s->decl->child[1];
+  while (arg != NULL && param != NULL)
+  { if (param->kind.decl == ArrParamK ? arg->type != IntArray
+                                      : arg->type != Integer)
+    { outPrintf(cc->listing,"Type error at line %d: argument of %s "
+                "is not %s\n",locLine(cc,arg->loc),s->name,
+                param->kind.decl == ArrParamK ? "an array" : "an integer");
+      cc->Error = TRUE;
+    }
+    arg = arg->sibling;
+    param = param->sibling;
+  }
+  if (arg != NULL || param != NULL)
+  { outPrintf(cc->listing,"Type error at line %d: %s called with too "
+              "%s arguments\n",locLine(cc,t->loc),s->name,
+              arg != NULL ? "many" : "few");
+    cc->Error = TRUE;
+  }
 }
 
-/* Procedure checkNode performs
- * type checking at a single tree node
+/* Procedure checkNode performs type checking at a
+ * single tree node, whose children are checked,
+ * with the symbol in its frame; the postorder hook
+ * of both analyze and typeCheck
  */
-static void checkNode(TreeNode * t)
-{ switch (t->nodekind)
+static void checkNode( Compiler * cc, TreeNode * t )
+{ Symbol * s = named(t) ? st_symbol(cc,walkFrame(cc,0)->local[0]) : NULL;
+  switch (t->nodekind)
   { case ExpK:
+      t->type = Integer;
       switch (t->kind.exp)
       { case OpK:
           if ((t->child[0]->type != Integer) ||
               (t->child[1]->type != Integer))
-            typeError(t,"Op applied to non-integer");
-          if ((t->attr.op == EQ) || (t->attr.op == LT))
-            t->type = Boolean;
-          else
-            t->type = Integer;
+            typeError(cc,t,"Op applied to non-integer");
+          break;
+        case AssignK:
+          if (t->child[0]->type != Integer)
+            typeError(cc,t->child[0],"assignment to non-integer variable");
+          else if (t->child[1]->type != Integer)
+            typeError(cc,t->child[1],"assignment of non-integer value");
           break;
-        case ConstK:
         case IdK:
-          t->type = Integer;
+          if (s == NULL) break;
+          if (s->kind == FuncK)
+            nameError(cc,t,s->name,"is a function, not a variable");
+          else if (isArray(s)) t->type = IntArray;
+          break;
+        case ArrIdK:
+          if (s == NULL) break;
+          if (!isArray(s)) nameError(cc,t,s->name,"is not an array");
+          if (t->child[0]->type != Integer)
+            typeError(cc,t->child[0],"array index is not an integer");
+          break;
+        case CallK:
+          if (s == NULL) break;
+          if (s->kind != FuncK)
+            nameError(cc,t,s->name,"is not a function");
+          else
+          { checkCall(cc,t,s);
+            t->type = s->type;
+          }
           break;
         default:
           break;
@@ -126,20 +262,21 @@ static void checkNode(TreeNode * t)
     case StmtK:
       switch (t->kind.stmt)
       { case IfK:
-          if (t->child[0]->type == Integer)
-            typeError(t->child[0],"if test is not Boolean");
-          break;
-        case AssignK:
           if (t->child[0]->type != Integer)
-            typeError(t->child[0],"assignment of non-integer value");
+            typeError(cc,t->child[0],"if test is not an integer");
           break;
-        case WriteK:
+        case LoopK:
           if (t->child[0]->type != Integer)
-            typeError(t->child[0],"write of non-integer value");
+            typeError(cc,t->child[0],"while test is not an integer");
           break;
-        case RepeatK:
-          if (t->child[1]->type == Integer)
-            typeError(t->child[1],"repeat test is not Boolean");
+        case RetK:
+          if (cc->function == NULL) break;
+          if (cc->function->type == Void && t->child[0] != NULL)
+            typeError(cc,t,"return with a value in a void function");
+          else if (cc->function->type == Integer && t->child[0] == NULL)
+            typeError(cc,t,"return without a value in an int function");
+          else if (t->child[0] != NULL && t->child[0]->type != Integer)
+            typeError(cc,t->child[0],"return of non-integer value");
           break;
         default:
           break;
@@ -147,13 +284,241 @@ static void checkNode(TreeNode * t)
       break;
     default:
       break;
+  }
+}
+
+/* checkMain checks that the last declaration of the
+ * program is void main(void), after the rest is
+ * analyzed
+ */
+static void checkMain( Compiler * cc, TreeNode * syntaxTree )
+{ Atom main = intern(cc,"main",4);
+  TreeNode * last = syntaxTree;
+  if (last == NULL) return;
+  while (last->sibling != NULL) last = last->sibling;
+  if (last->nodekind != DeclK || last->kind.decl != FuncK
+      || last->attr.name != main)
+    nameError(cc,last,main,"is not the last declaration");
+  else if (last->type != Void || last->child[1] != NULL)
+    nameError(cc,last,main,"is not declared void main(void)");
+}
+
+/* the postorder hook of analyze */
+static void checkAndClose( Compiler * cc, TreeNode * t )
+{ checkNode(cc,t);
+  closeNode(cc,t);
+}
+
+/* Procedure analyze declares, resolves and type
+ * checks the names of the syntax tree in a single
+ * traversal: declarations on the way down, checks
+ * on the way up, when the types of the children
+ * are known
+ */
+void analyze(Compiler * cc, TreeNode * syntaxTree)
+{ if (cc->AnalyzeThreads > 1 && !cc->TraceAnalyze)
+  { analyzeParallel(cc,syntaxTree,cc->AnalyzeThreads);
+    return;
+  }
+  declareBuiltins(cc);
+  walkTree(cc,syntaxTree,declareNode,NULL,checkAndClose);
+  checkMain(cc,syntaxTree);
+  if (cc->TraceAnalyze)
+  { outStr(cc->listing,"\nSymbol table:\n\n");
+    printSymTab(cc);
+  }
+}
+
+/* the preorder hook of buildSymtab: declareNode,
+   keeping the symbol each node finds for typeCheck */
+static void bindNode( Compiler * cc, TreeNode * t )
+{ declareNode(cc,t);
+  if (named(t))
+  { cc->binding = growInts(cc->binding,&cc->bindCap,cc->bindCount);
+    cc->binding[cc->bindCount++] = walkFrame(cc,0)->local[0];
+  }
+}
+
+/* Function buildSymtab constructs the symbol
+ * table by preorder traversal of the syntax tree
+ */
+void buildSymtab(Compiler * cc, TreeNode * syntaxTree)
+{ cc->bindCount = 0;
+  declareBuiltins(cc);
+  walkTree(cc,syntaxTree,bindNode,NULL,closeNode);
+  if (cc->TraceAnalyze)
+  { outStr(cc->listing,"\nSymbol table:\n\n");
+    printSymTab(cc);
+  }
+}
 
+/* the hooks of typeCheck: a node gets back the
+   symbol buildSymtab found for it */
+static void boundNode( Compiler * cc, TreeNode * t )
+{ WalkFrame * f = walkFrame(cc,0);
+  if (named(t))
+  { f->local[0] = cc->binding[cc->bindNext++];
+    if (t->nodekind == DeclK && t->kind.decl == FuncK)
+      cc->function = st_symbol(cc,f->local[0]);
   }
 }
 
-/* Procedure typeCheck performs type checking 
- * by a postorder syntax tree traversal
+static void checkBoundNode( Compiler * cc, TreeNode * t )
+{ checkNode(cc,t);
+  if (t->nodekind == DeclK && t->kind.decl == FuncK) cc->function = NULL;
+}
+
+/* Procedure typeCheck performs type checking
+ * by a postorder syntax tree traversal, with the
+ * symbols buildSymtab found, which it then releases
+ */
+void typeCheck(Compiler * cc, TreeNode * syntaxTree)
+{ cc->bindNext = 0;
+  walkTree(cc,syntaxTree,boundNode,NULL,checkBoundNode);
+  checkMain(cc,syntaxTree);
+  free(cc->binding);
+  cc->binding = NULL;
+  cc->bindCount = cc->bindCap = 0;
+}
+
+/* The parallel analysis. The global declarations
+ * are declared first, on the calling thread; then
+ * each thread analyzes the bodies of a run of
+ * consecutive functions in a Compiler of its own,
+ * whose symbol table shares the global scope. What
+ * the global pass and each body print is kept apart
+ * and put together afterwards in the order the
+ * serial analysis prints it
+ */
+
+/* a top-level declaration */
+typedef struct
+   { TreeNode * t;
+     Symbol * sym;    /* what it declares, or NULL */
+     int visible;     /* the global symbols declared by then */
+     size_t global;   /* where its errors start in the global output */
+     size_t body;     /* where those of its body start in its thread's */
+   } TopDecl;
+
+/* the share of a thread: the top-level declarations
+   first to last-1 */
+typedef struct
+   { Compiler w;
+     TopDecl * top;
+     int first, last;
+   } Share;
+
+static void analyzeShare( Share * sh )
+{ Compiler * w = &sh->w;
+  int i;
+  for (i = sh->first; i < sh->last; i++)
+  { TopDecl * d = &sh->top[i];
+    d->body = w->out.len;
+    if (d->t->nodekind != DeclK || d->t->kind.decl != FuncK) continue;
+    /* a body sees only the globals declared before it */
+    st_hideGlobals(w,d->visible);
+    openFunction(w,d->sym);
+    walkTree(w,d->t->child[1],declareNode,NULL,checkAndClose);
+    walkTree(w,d->t->child[2],declareNode,NULL,checkAndClose);
+    st_exitScope(w);
+    w->function = NULL;
+  }
+}
+
+static void * analyzeThread( void * arg )
+{ analyzeShare((Share *) arg);
+  return NULL;
+}
+
+/* Procedure analyzeParallel does what analyze does,
+ * and prints the same, with the function bodies
+ * analyzed concurrently on up to nthreads threads
  */
-void typeCheck(TreeNode * syntaxTree)
-{ traverse(syntaxTree,nullProc,checkNode);
+void analyzeParallel(Compiler * cc, TreeNode * syntaxTree, int nthreads)
+{ TopDecl * top;
+  Share * share;
+  Compiler ** w;
+  pthread_t * thread;
+  Out global, * listing = cc->listing;
+  TreeNode * t;
+  int n, nfuncs, i, k;
+  for (n = nfuncs = 0, t = syntaxTree; t != NULL; t = t->sibling, n++)
+    if (t->nodekind == DeclK && t->kind.decl == FuncK) nfuncs++;
+  if (nthreads > nfuncs) nthreads = nfuncs;
+  if (nthreads < 2)
+  { declareBuiltins(cc);
+    walkTree(cc,syntaxTree,declareNode,NULL,checkAndClose);
+    checkMain(cc,syntaxTree);
+    return;
+  }
+  top = malloc(n * sizeof(TopDecl));
+  share = calloc(nthreads,sizeof(Share));
+  w = malloc(nthreads * sizeof(Compiler *));
+  thread = malloc(nthreads * sizeof(pthread_t));
+  if (top == NULL || share == NULL || w == NULL || thread == NULL)
+  { fprintf(stderr,"Out of memory for %d threads\n",nthreads);
+    exit(1);
+  }
+  /* the global pass */
+  outOpen(&global,NULL);
+  cc->listing = &global;
+  declareBuiltins(cc);
+  for (i = 0, t = syntaxTree; t != NULL; t = t->sibling, i++)
+  { top[i].t = t;
+    top[i].global = global.len;
+    top[i].sym = t->nodekind == DeclK ? declare(cc,t) : NULL;
+    top[i].visible = st_count(cc);
+  }
+  cc->listing = listing;
+  /* the line table is built on first use, so it is
+     built before the threads need it */
+  locLine(cc,syntaxTree->loc);
+  /* the shares split the source into even parts */
+  for (k = 0, i = 0; k < nthreads; k++)
+  { Share * sh = &share[k];
+    int end = (int) ((long long) cc->srcLen * (k + 1) / nthreads);
+    sh->top = top;
+    sh->first = i;
+    while (i < n && (k == nthreads - 1 || locOffset(top[i].t->loc) < end))
+      i++;
+    sh->last = i;
+    compilerInit(&sh->w,cc->pgm);
+    outOpen(&sh->w.out,NULL);
+    sh->w.files = cc->files;
+    st_shareGlobals(&sh->w,cc);
+    w[k] = &sh->w;
+  }
+  for (k = 1; k < nthreads; k++)
+    if (pthread_create(&thread[k],NULL,analyzeThread,&share[k]) != 0)
+    { fprintf(stderr,"Cannot start analyzer thread\n");
+      exit(1);
+    }
+  analyzeShare(&share[0]);
+  for (k = 1; k < nthreads; k++)
+    pthread_join(thread[k],NULL);
+  /* the errors of each declaration, then of its body */
+  for (k = 0; k < nthreads; k++)
+  { Share * sh = &share[k];
+    for (i = sh->first; i < sh->last; i++)
+    { size_t gend = i + 1 < n ? top[i+1].global : global.len;
+      size_t bend = i + 1 < sh->last ? top[i+1].body : sh->w.out.len;
+      outMem(listing,global.buf + top[i].global,gend - top[i].global);
+      outMem(listing,sh->w.out.buf + top[i].body,bend - top[i].body);
+    }
+    if (sh->w.Error) cc->Error = TRUE;
+  }
+  st_merge(cc,w,nthreads);
+  checkMain(cc,syntaxTree);
+  for (k = 0; k < nthreads; k++)
+  { Share * sh = &share[k];
+    st_free(&sh->w);
+    walkFree(&sh->w);
+    arenaAdopt(cc,&sh->w);
+    outClose(&sh->w.out);
+  }
+  outClose(&global);
+  free(thread);
+  free(w);
+  free(share);
+  free(top);
 }
@@ -1,6 +1,6 @@
 /****************************************************/
 /* File: analyze.h                                  */
-/* Semantic analyzer interface for TINY compiler    */
+/* Semantic analyzer interface for C- compiler      */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,14 +8,34 @@
 #ifndef _ANALYZE_H_
 #define _ANALYZE_H_
 
+/* Procedure analyze declares, resolves and type
+ * checks the names of the syntax tree in a single
+ * traversal: declarations on the way down, checks
+ * on the way up, when the types of the children
+ * are known
+ */
+void analyze(Compiler *, TreeNode *);
+
+/* Procedure analyzeParallel does what analyze does,
+ * and prints the same, with the function bodies
+ * analyzed concurrently on up to nthreads threads;
+ * analyze calls it when AnalyzeThreads > 1
+ */
+void analyzeParallel(Compiler *, TreeNode *, int nthreads);
+
+/* buildSymtab and typeCheck do the same in two
+ * traversals, one after the other
+ */
+
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
  */
-void buildSymtab(TreeNode *);
+void buildSymtab(Compiler *, TreeNode *);
 
 /* Procedure typeCheck performs type checking 
- * by a postorder syntax tree traversal
+ * by a postorder syntax tree traversal, with the
+ * symbols buildSymtab found, which it then releases
  */
-void typeCheck(TreeNode *);
+void typeCheck(Compiler *, TreeNode *);
 
 #endif
@@ -0,0 +1,143 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Per-compilation bump allocator for syntax tree   */
+/* nodes and identifier text                        */
+/* Allocations are carved out of large blocks by    */
+/* bumping a pointer; blocks are only released when */
+/* the compilation is over                          */
+/****************************************************/
+
+#include <stddef.h>
+#include "globals.h"
+#include "arena.h"
+
+/* most allocations come from blocks of BLOCKSIZE
+   bytes; one over a quarter of that gets a block of
+   its own, so a block is never mostly wasted */
+#define BLOCKSIZE (64*1024)
+
+/* allocations are rounded up to this alignment */
+#define ALIGN sizeof(void *)
+
+typedef struct BlockRec
+   { struct BlockRec * next;
+     size_t size;
+     char mem[];
+   } * Block;
+
+struct arena
+   { Block blocks;     /* newest first */
+     char * next;      /* free space in the newest block */
+     char * end;
+     size_t used;      /* bytes handed out */
+     size_t reserved;  /* bytes in blocks */
+   };
+
+/* newBlock adds a block with room for at least size
+ * bytes to the arena
+ */
+static void newBlock( struct arena * a, size_t size )
+{ size_t bsize = size > BLOCKSIZE / 4 ? size : BLOCKSIZE;
+  Block b = malloc(offsetof(struct BlockRec,mem) + bsize);
+  if (b == NULL)
+  { fprintf(stderr,"Out of memory for the syntax tree\n");
+    exit(1);
+  }
+  b->next = a->blocks;
+  b->size = bsize;
+  a->blocks = b;
+  a->next = b->mem;
+  a->end = b->mem + bsize;
+  a->reserved += bsize;
+}
+
+/* Function arenaAlloc returns size bytes from the
+ * arena of cc, aligned for any pointer or int
+ */
+void * arenaAlloc( Compiler * cc, size_t size )
+{ struct arena * a = cc->arena;
+  void * p;
+  size = (size + ALIGN - 1) & ~(ALIGN - 1);
+  if (a == NULL)
+  { a = cc->arena = calloc(1,sizeof(struct arena));
+    if (a == NULL)
+    { fprintf(stderr,"Out of memory for the syntax tree\n");
+      exit(1);
+    }
+  }
+  if ((size_t) (a->end - a->next) < size) newBlock(a,size);
+  p = a->next;
+  a->next += size;
+  a->used += size;
+  return p;
+}
+
+/* Function arenaUsed returns the number of bytes
+ * handed out by arenaAlloc since the arena of cc was
+ * last reset, and sets *reserved, unless it is NULL,
+ * to the bytes of the blocks they came from
+ */
+size_t arenaUsed( Compiler * cc, size_t * reserved )
+{ struct arena * a = cc->arena;
+  if (reserved != NULL) *reserved = a ? a->reserved : 0;
+  return a ? a->used : 0;
+}
+
+/* Procedure arenaReset releases everything in the
+ * arena of cc but keeps its newest block, so a
+ * long-running process does not allocate it again
+ */
+void arenaReset( Compiler * cc )
+{ struct arena * a = cc->arena;
+  if (a == NULL || a->blocks == NULL) return;
+  while (a->blocks->next != NULL)
+  { Block next = a->blocks->next->next;
+    free(a->blocks->next);
+    a->blocks->next = next;
+  }
+  a->next = a->blocks->mem;
+  a->end = a->blocks->mem + a->blocks->size;
+  a->used = 0;
+  a->reserved = a->blocks->size;
+}
+
+/* Procedure arenaAdopt moves everything in the
+ * arena of from into that of cc, to be released with
+ * it, and leaves from with no arena
+ */
+void arenaAdopt( Compiler * cc, Compiler * from )
+{ struct arena * a = cc->arena, * f = from->arena;
+  Block last;
+  if (f == NULL) return;
+  if (a == NULL || a->blocks == NULL)
+  { arenaFree(cc);
+    cc->arena = f;
+    from->arena = NULL;
+    return;
+  }
+  /* the blocks of from go after the newest of cc,
+     which goes on handing out its free space */
+  if (f->blocks != NULL)
+  { for (last = f->blocks; last->next != NULL; last = last->next)
+      ;
+    last->next = a->blocks->next;
+    a->blocks->next = f->blocks;
+  }
+  a->used += f->used;
+  a->reserved += f->reserved;
+  free(f);
+  from->arena = NULL;
+}
+
+/* Procedure arenaFree releases the arena of cc */
+void arenaFree( Compiler * cc )
+{ struct arena * a = cc->arena;
+  if (a == NULL) return;
+  while (a->blocks != NULL)
+  { Block next = a->blocks->next;
+    free(a->blocks);
+    a->blocks = next;
+  }
+  free(a);
+  cc->arena = NULL;
+}
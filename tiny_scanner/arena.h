@@ -0,0 +1,43 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Per-compilation bump allocator for syntax tree   */
+/* nodes and identifier text                        */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+/* Everything allocated from the arena of cc lives
+ * until the compilation ends: nothing is freed on
+ * its own, and compilerReset or compilerFree release
+ * it all at once
+ */
+
+/* Function arenaAlloc returns size bytes from the
+ * arena of cc, aligned for any pointer or int
+ */
+void * arenaAlloc( Compiler * cc, size_t size );
+
+/* Function arenaUsed returns the number of bytes
+ * handed out by arenaAlloc since the arena of cc was
+ * last reset, and sets *reserved, unless it is NULL,
+ * to the bytes of the blocks they came from
+ */
+size_t arenaUsed( Compiler * cc, size_t * reserved );
+
+/* Procedure arenaReset releases everything in the
+ * arena of cc but keeps its newest block, so a
+ * long-running process does not allocate it again
+ */
+void arenaReset( Compiler * cc );
+
+/* Procedure arenaAdopt moves everything in the
+ * arena of from into that of cc, to be released with
+ * it, and leaves from with no arena
+ */
+void arenaAdopt( Compiler * cc, Compiler * from );
+
+/* Procedure arenaFree releases the arena of cc */
+void arenaFree( Compiler * cc );
+
+#endif
@@ -0,0 +1,204 @@
+/****************************************************/
+/* File: astfile.c                                  */
+/* Syntax tree images: a flat tree written to a     */
+/* file that later runs map and walk in place       */
+/* A flat tree holds no pointers, so its arrays are */
+/* written as they are and the loaded FlatTree      */
+/* points straight into the mapping                 */
+/****************************************************/
+
+#include "globals.h"
+#include "flat.h"
+#include "srcloc.h"
+#include "astfile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* sections start at multiples of ALIGN bytes */
+#define ALIGN 8
+
+/* sectionSize returns the bytes of section s of an
+ * image of count nodes, nameCount names and strLen
+ * bytes of names
+ */
+static size_t sectionSize( int s, int count, int nameCount, int strLen )
+{ if (s <= AstType) return (size_t) count;
+  if (s <= AstAttr) return (size_t) count * sizeof(int);
+  if (s == AstNames) return (size_t) nameCount * sizeof(FlatName);
+  return (size_t) strLen;
+}
+
+/* layout sets the offsets of the sections of h and
+ * returns the length of the image
+ */
+static size_t layout( AstHeader * h )
+{ size_t off = (sizeof(AstHeader) + ALIGN - 1) & ~(size_t) (ALIGN - 1);
+  int s;
+  for (s = 0; s < AST_SECTIONS; s++)
+  { h->off[s] = (unsigned) off;
+    off += sectionSize(s,h->count,h->nameCount,h->strLen);
+    off = (off + ALIGN - 1) & ~(size_t) (ALIGN - 1);
+  }
+  return off;
+}
+
+/* writeBytes writes len bytes, and then as many
+ * zeros as bring total, the length of the section so
+ * far, to a multiple of ALIGN; returns FALSE on an
+ * error
+ */
+static int writeBytes( FILE * out, const void * p, size_t len, size_t total )
+{ static const char zeros[ALIGN];
+  size_t pad = (ALIGN - total % ALIGN) % ALIGN;
+  return (len == 0 || fwrite(p,1,len,out) == len)
+         && (pad == 0 || fwrite(zeros,1,pad,out) == pad);
+}
+
+/* writePadded writes a section of len bytes */
+#define writePadded(out,p,len) writeBytes(out,p,len,len)
+
+/* Function astDump writes the flat tree f of cc to
+ * the file path as an image. Returns FALSE if the
+ * file cannot be written
+ */
+int astDump( Compiler * cc, FlatTree * f, const char * path )
+{ AstHeader h;
+  FILE * out;
+  int * line;
+  int n, ok, pgmLen = strlen(cc->pgm) + 1;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,AST_MAGIC,sizeof(h.magic));
+  h.version = AST_VERSION;
+  h.order = AST_ORDER;
+  h.count = f->count;
+  h.nameCount = f->nameCount;
+  /* the source file name follows the names */
+  h.pgm = f->strLen;
+  h.strLen = f->strLen + pgmLen;
+  layout(&h);
+  line = malloc((f->count > 0 ? f->count : 1) * sizeof(int));
+  if (line == NULL)
+  { fprintf(stderr,"Out of memory for %d flat tree nodes\n",f->count);
+    exit(1);
+  }
+  for (n = 0; n < f->count; n++) line[n] = locLine(cc,f->loc[n]);
+  if ((out = fopen(path,"wb")) == NULL)
+  { free(line);
+    return FALSE;
+  }
+  ok = writePadded(out,&h,sizeof(h))
+       && writePadded(out,f->nodekind,f->count)
+       && writePadded(out,f->kind,f->count)
+       && writePadded(out,f->slot,f->count)
+       && writePadded(out,f->type,f->count)
+       && writePadded(out,f->loc,f->count * sizeof(SrcLoc))
+       && writePadded(out,line,f->count * sizeof(int))
+       && writePadded(out,f->child,f->count * sizeof(int))
+       && writePadded(out,f->sibling,f->count * sizeof(int))
+       && writePadded(out,f->attr,f->count * sizeof(int))
+       && writePadded(out,f->names,f->nameCount * sizeof(FlatName))
+       /* pgm goes right after the names */
+       && writeBytes(out,f->strtab,f->strLen,0)
+       && writeBytes(out,cc->pgm,pgmLen,h.strLen);
+  free(line);
+  if (fclose(out) != 0) ok = FALSE;
+  return ok;
+}
+
+/* valid tells whether the len bytes at h hold an
+ * image of this version whose sections are all
+ * inside them; the node links themselves are trusted
+ */
+static int valid( const AstHeader * h, size_t len, const char ** reason )
+{ AstHeader want;
+  if (len < sizeof(AstHeader)
+      || memcmp(h->magic,AST_MAGIC,sizeof(h->magic)) != 0)
+  { *reason = "not a syntax tree image";
+    return FALSE;
+  }
+  if (h->version != AST_VERSION || h->order != AST_ORDER)
+  { *reason = "image of another version or byte order";
+    return FALSE;
+  }
+  want = *h;
+  if (h->count < 0 || h->nameCount < 0 || h->strLen <= 0
+      || h->pgm < 0 || h->pgm >= h->strLen
+      || layout(&want) > len
+      || memcmp(want.off,h->off,sizeof(h->off)) != 0
+      || ((const char *) h)[h->off[AstStrtab] + h->strLen - 1] != '\0')
+  { *reason = "truncated or damaged image";
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Function astLoad maps the image in the file path
+ * read-only and returns a FlatTree whose arrays
+ * point into the mapping, so it is walked without
+ * being read in; its line[] holds the line of each
+ * node. Returns NULL, and sets *reason to why, if
+ * the file cannot be mapped or is not an image of
+ * this version
+ */
+FlatTree * astLoad( const char * path, const char ** reason )
+{ struct stat st;
+  FlatTree * f;
+  char * base;
+  const AstHeader * h;
+  int fd = open(path,O_RDONLY);
+  if (fd < 0 || fstat(fd,&st) < 0 || !S_ISREG(st.st_mode)
+      || st.st_size < (off_t) sizeof(AstHeader))
+  { *reason = fd < 0 ? "cannot be opened" : "not a syntax tree image";
+    if (fd >= 0) close(fd);
+    return NULL;
+  }
+  base = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (base == MAP_FAILED)
+  { *reason = "cannot be mapped";
+    return NULL;
+  }
+  h = (const AstHeader *) base;
+  if (!valid(h,st.st_size,reason))
+  { munmap(base,st.st_size);
+    return NULL;
+  }
+  if ((f = calloc(1,sizeof(FlatTree))) == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  /* cap stays 0: the arrays belong to the mapping */
+  f->count = h->count;
+  f->nodekind = (unsigned char *) base + h->off[AstNodeKind];
+  f->kind = (unsigned char *) base + h->off[AstKind];
+  f->slot = (unsigned char *) base + h->off[AstSlot];
+  f->type = (unsigned char *) base + h->off[AstType];
+  f->loc = (SrcLoc *) (base + h->off[AstLoc]);
+  f->line = (int *) (base + h->off[AstLine]);
+  f->child = (int *) (base + h->off[AstChild]);
+  f->sibling = (int *) (base + h->off[AstSibling]);
+  f->attr = (int *) (base + h->off[AstAttr]);
+  f->names = (FlatName *) (base + h->off[AstNames]);
+  f->nameCount = h->nameCount;
+  f->strtab = base + h->off[AstStrtab];
+  f->strLen = h->strLen;
+  f->map = base;
+  f->mapLen = st.st_size;
+  return f;
+}
+
+/* Function astSource returns the name of the source
+ * file of a loaded image
+ */
+const char * astSource( FlatTree * f )
+{ return f->strtab + ((const AstHeader *) f->map)->pgm;
+}
+
+/* Procedure astUnload unmaps a loaded image */
+void astUnload( FlatTree * f )
+{ munmap(f->map,f->mapLen);
+  free(f);
+}
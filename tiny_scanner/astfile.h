@@ -0,0 +1,72 @@
+/****************************************************/
+/* File: astfile.h                                  */
+/* Syntax tree images: a flat tree written to a     */
+/* file that later runs map and walk in place       */
+/****************************************************/
+
+#ifndef _ASTFILE_H_
+#define _ASTFILE_H_
+
+/* AST_VERSION is stored in every image; change it
+ * whenever the layout below or the meaning of the
+ * node kinds, attributes or tokens changes
+ */
+#define AST_VERSION 1
+
+/* the sections of an image, in file order */
+enum
+   { AstNodeKind, AstKind, AstSlot, AstType,  /* a byte per node */
+     AstLoc, AstLine, AstChild, AstSibling, AstAttr, /* an int per node */
+     AstNames,                                /* a FlatName per name */
+     AstStrtab,                               /* strLen bytes */
+     AST_SECTIONS
+   };
+
+/* An image starts with an AstHeader, followed by
+ * the sections, each at a multiple of 8 bytes. The
+ * node arrays and the string table are exactly those
+ * of the FlatTree (flat.h) it was written from, in
+ * the byte order of the machine that wrote it, plus
+ * the line of each node so that nothing needs the
+ * source. pgm is the offset of the name of the
+ * source file in the string table
+ */
+typedef struct
+   { char magic[8];      /* AST_MAGIC */
+     unsigned version;   /* AST_VERSION */
+     unsigned order;     /* AST_ORDER as written */
+     int count;          /* nodes */
+     int nameCount;
+     int strLen;
+     int pgm;
+     unsigned off[AST_SECTIONS];
+   } AstHeader;
+
+#define AST_MAGIC "C-AST\r\n\032"
+#define AST_ORDER 0x01020304u
+
+/* Function astDump writes the flat tree f of cc to
+ * the file path as an image. Returns FALSE if the
+ * file cannot be written
+ */
+int astDump( Compiler * cc, FlatTree * f, const char * path );
+
+/* Function astLoad maps the image in the file path
+ * read-only and returns a FlatTree whose arrays
+ * point into the mapping, so it is walked without
+ * being read in; its line[] holds the line of each
+ * node. Returns NULL, and sets *reason to why, if
+ * the file cannot be mapped or is not an image of
+ * this version
+ */
+FlatTree * astLoad( const char * path, const char ** reason );
+
+/* Function astSource returns the name of the source
+ * file of a loaded image
+ */
+const char * astSource( FlatTree * f );
+
+/* Procedure astUnload unmaps a loaded image */
+void astUnload( FlatTree * f );
+
+#endif
@@ -0,0 +1,171 @@
+/****************************************************/
+/* File: cgenbench.c                                */
+/* Code generation benchmark: generates the TM code */
+/* of each file, every name found through the       */
+/* symbol analysis bound to its node, and times     */
+/* that against what finding them took without the  */
+/* bindings: opening the scopes over again and      */
+/* looking every name up in a symbol table. Checks  */
+/* that each lookup finds the bound symbol          */
+/* usage: cgenbench file...                         */
+/* exits with 1 if a lookup finds another symbol    */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "parse.h"
+#include "symtab.h"
+#include "analyze.h"
+#include "cgen.h"
+#include "arena.h"
+#include "walk.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the nodes of the tree, counted by countNode */
+static long nodes;
+
+static void countNode( Compiler * cc, TreeNode * t )
+{ nodes++;
+}
+
+/* CGENREPS is the number of nodes each pass is
+   timed on at least, running small files repeatedly */
+#define CGENREPS 20000000
+
+/* the lookups that did not find the bound symbol */
+static long wrong;
+
+/* named tells whether t names a symbol */
+static int named( TreeNode * t )
+{ return t->nodekind == ExpK && (t->kind.exp == IdK
+         || t->kind.exp == ArrIdK || t->kind.exp == CallK);
+}
+
+/* the lookups run in a table of their own, where
+   funcBody tells that the next compound statement
+   is the body of a function, sharing its scope */
+static int funcBody;
+
+/* lookupPre declares what t declares again and
+   looks up what it names, as analyze does; a
+   compound statement keeps in local[0] whether it
+   opened a scope */
+static void lookupPre( Compiler * cc, TreeNode * t )
+{ int * local = walkFrame(cc,0)->local;
+  Symbol * s;
+  if (t->nodekind == DeclK)
+  { s = t->sym;
+    st_declare(cc,s->name,s->kind,s->type,s->size,s->offset,t);
+    if (t->kind.decl == FuncK)
+    { st_enterScope(cc);
+      funcBody = TRUE;
+    }
+    else walkSkip(cc);
+  }
+  else if (t->nodekind == StmtK && t->kind.stmt == CompK)
+  { local[0] = !funcBody;
+    if (!funcBody) st_enterScope(cc);
+    funcBody = FALSE;
+  }
+  else if (named(t))
+  { s = st_find(cc,t->attr.name);
+    if (s == NULL || s->offset != t->sym->offset || s->kind != t->sym->kind
+        || s->scope != t->sym->scope) wrong++;
+  }
+}
+
+static void lookupPost( Compiler * cc, TreeNode * t )
+{ if ((t->nodekind == DeclK && t->kind.decl == FuncK)
+      || (t->nodekind == StmtK && t->kind.stmt == CompK
+          && walkFrame(cc,0)->local[0]))
+    st_exitScope(cc);
+}
+
+/* lookup runs the lookups over the functions of
+   tree, in the table of scratch, the predeclared
+   functions first */
+static void lookup( Compiler * cc, Compiler * scratch, TreeNode * tree )
+{ int i;
+  st_free(scratch);
+  arenaReset(scratch);
+  for (i = 0; i < 2; i++)
+  { Symbol * s = st_symbol(cc,i);
+    st_declare(scratch,s->name,s->kind,s->type,s->size,s->offset,s->decl);
+  }
+  walkTree(scratch,tree,lookupPre,NULL,lookupPost);
+}
+
+int main( int argc, char * argv[] )
+{ int i, differ = 0;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  RDParse = TRUE;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename>...\n",argv[0]);
+    exit(1);
+  }
+  for (i = 1; i < argc; i++)
+  { Compiler cc, scratch;
+    TreeNode * tree;
+    double tc = 0, tl = 0, t0;
+    int reps, k;
+    Out errors, code;
+    compilerInit(&cc,argv[i]);
+    if (!mapSource(&cc,argv[i])
+        || (cc.srcFile = srcFileAdd(&cc,argv[i],cc.srcBuf,cc.srcLen)) < 0)
+    { fprintf(stderr,"File %s not found\n",argv[i]);
+      exit(1);
+    }
+    /* the errors are not wanted */
+    outOpen(&errors,NULL);
+    cc.listing = &errors;
+    tree = parse(&cc);
+    if (tree != NULL && !cc.Error) analyze(&cc,tree);
+    outClose(&errors);
+    cc.listing = &cc.out;
+    if (tree == NULL || cc.Error)
+    { printf("%-24s does not compile\n",argv[i]);
+      compilerFree(&cc);
+      continue;
+    }
+    nodes = 0;
+    walkTree(&cc,tree,countNode,NULL,NULL);
+    reps = CGENREPS / nodes + 1;
+    outOpen(&code,NULL);
+    cc.code = &code;
+    compilerInit(&scratch,argv[i]);
+    wrong = 0;
+    for (k = 0; k < reps; k++)
+    { outReset(&code);
+      cc.emitLoc = cc.highEmitLoc = 0;
+      t0 = now();
+      codeGen(&cc,tree,"cgenbench.tm");
+      tc += now() - t0;
+      t0 = now();
+      lookup(&cc,&scratch,tree);
+      tl += now() - t0;
+    }
+    tc /= reps;
+    tl /= reps;
+    printf("%-24s %9ld nodes  code %8.4f s %6.1f ns/node"
+           "  lookups %8.4f s %6.1f ns/node  saved %4.1f%%  %s\n",
+           argv[i],nodes,tc,tc/nodes*1e9,tl,tl/nodes*1e9,
+           100 * tl / (tc + tl),wrong ? "WRONG" : "same");
+    if (wrong) differ = 1;
+    outClose(&code);
+    cc.code = NULL;
+    compilerFree(&scratch);
+    compilerFree(&cc);
+  }
+  return differ;
+}
@@ -0,0 +1,160 @@
+/****************************************************/
+/* File: cmclient.c                                 */
+/* Client for the compile server (hw1_binary -serve)*/
+/* sends a file n times and reports the latency     */
+/* usage: cmclient socket [-t] [-n N] [-f flags]    */
+/*                 [-l] file                        */
+/*        cmclient socket -stop                     */
+/*        cmclient -spawn prog [-n N] file          */
+/* (the last runs prog file in a new process each   */
+/*  time, for comparison)                           */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fail( const char * what )
+{ perror(what);
+  exit(1);
+}
+
+static void writeAll( int fd, const char * p, size_t n )
+{ while (n > 0)
+  { ssize_t k = write(fd,p,n);
+    if (k <= 0) fail("write");
+    p += k;
+    n -= k;
+  }
+}
+
+static void readAll( FILE * f, char * p, size_t n )
+{ if (n > 0 && fread(p,1,n,f) != n) fail("read");
+}
+
+/* slurp returns the contents of path */
+static char * slurp( const char * path, long * len )
+{ FILE * f = fopen(path,"rb");
+  char * buf;
+  if (f == NULL) fail(path);
+  fseek(f,0,SEEK_END);
+  *len = ftell(f);
+  rewind(f);
+  buf = malloc(*len + 1);
+  if (buf == NULL) fail("malloc");
+  readAll(f,buf,*len);
+  fclose(f);
+  return buf;
+}
+
+static void usage( const char * prog )
+{ fprintf(stderr,"usage: %s socket [-t] [-n N] [-f flags] [-l] file\n"
+                 "       %s socket -stop\n"
+                 "       %s -spawn prog [-n N] file\n",prog,prog,prog);
+  exit(1);
+}
+
+/* spawn runs prog file n times, one process each */
+static void spawn( const char * prog, const char * file, int n )
+{ double t, min = 1e9, max = 0, sum = 0;
+  int i, status;
+  for (i = 0; i < n; i++)
+  { pid_t pid;
+    t = now();
+    pid = fork();
+    if (pid < 0) fail("fork");
+    if (pid == 0)
+    { execl(prog,prog,file,(char *) NULL);
+      _exit(127);
+    }
+    if (waitpid(pid,&status,0) < 0) fail("waitpid");
+    t = now() - t;
+    if (t < min) min = t;
+    if (t > max) max = t;
+    sum += t;
+  }
+  printf("%d processes: min %.1f avg %.1f max %.1f usec\n",
+         n,min*1e6,sum/n*1e6,max*1e6);
+}
+
+int main( int argc, char * argv[] )
+{ struct sockaddr_un addr;
+  const char * flags = "-", * file = NULL;
+  int text = 0, n = 1, print = 0, stop = 0, fd, i;
+  long srcLen = 0;
+  char * src = NULL, header[256];
+  double t, min = 1e9, max = 0, sum = 0, server = 0;
+  FILE * in;
+  if (argc < 3) usage(argv[0]);
+  for (i = strcmp(argv[1],"-spawn") == 0 ? 3 : 2; i < argc; i++)
+    if (strcmp(argv[i],"-t") == 0) text = 1;
+    else if (strcmp(argv[i],"-l") == 0) print = 1;
+    else if (strcmp(argv[i],"-stop") == 0) stop = 1;
+    else if (strcmp(argv[i],"-n") == 0 && i+1 < argc) n = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-f") == 0 && i+1 < argc) flags = argv[++i];
+    else file = argv[i];
+  if (!stop && (file == NULL || n < 1)) usage(argv[0]);
+  if (strcmp(argv[1],"-spawn") == 0)
+  { spawn(argv[2],file,n);
+    return 0;
+  }
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path,argv[1],sizeof(addr.sun_path)-1);
+  fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (fd < 0 || connect(fd,(struct sockaddr *) &addr,sizeof(addr)) < 0)
+    fail(argv[1]);
+  in = fdopen(dup(fd),"r");
+  if (stop) n = 1;
+  else if (text) src = slurp(file,&srcLen);
+  for (i = 0; i < n; i++)
+  { int status;
+    unsigned long listLen, codeLen;
+    long usec;
+    char * reply;
+    t = now();
+    if (stop)
+      snprintf(header,sizeof(header),"STOP - 0\n");
+    else if (text)
+      snprintf(header,sizeof(header),"TEXT %s %ld\n",flags,srcLen);
+    else
+      snprintf(header,sizeof(header),"PATH %s %ld\n",flags,(long) strlen(file));
+    writeAll(fd,header,strlen(header));
+    if (!stop)
+    { if (text) writeAll(fd,src,srcLen);
+      else writeAll(fd,file,strlen(file));
+    }
+    if (fgets(header,sizeof(header),in) == NULL
+        || sscanf(header,"%d %lu %lu %ld",&status,&listLen,&codeLen,&usec) != 4)
+      fail("reply");
+    reply = malloc(listLen + codeLen + 1);
+    if (reply == NULL) fail("malloc");
+    readAll(in,reply,listLen + codeLen);
+    t = now() - t;
+    if (print || (i == n-1 && status == 2))
+      fwrite(reply,1,listLen + codeLen,stdout);
+    free(reply);
+    if (t < min) min = t;
+    if (t > max) max = t;
+    sum += t;
+    server += usec * 1e-6;
+  }
+  if (!stop)
+    printf("%d requests: round trip min %.1f avg %.1f max %.1f usec, "
+           "in server avg %.1f usec\n",
+           n,min*1e6,sum/n*1e6,max*1e6,server/n*1e6);
+  fclose(in);
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/****************************************************/
+/* File: gencm.c                                    */
+/* Generates large C- programs for the benchmarks   */
+/* usage: gencm functions statements                */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* funcName spells function number f in letters,
+ * since C- identifiers cannot contain digits
+ */
+static const char * funcName(int f)
+{ static char buf[2][16];
+  static int which = 0;
+  char * p = buf[which ^= 1] + 15;
+  *p = '\0';
+  do { *--p = 'a' + f % 26; f /= 26; } while (f > 0);
+  *--p = 'f';
+  return p;
+}
+
+/* genStatement writes statement k of function f;
+ * every function declares x, y, z[10] and takes
+ * (int a, int b[]), and calls only earlier ones
+ */
+static void genStatement(int f, int k)
+{ switch (k % 7)
+  { case 0:
+      printf("    x = a + y * %d;\n",k);
+      break;
+    case 1:
+      printf("    y = (x - %d) / (a + 1);\n",k);
+      break;
+    case 2:
+      printf("    if (x < y) x = x + 1; else y = y - 1;\n");
+      break;
+    case 3:
+      printf("    /* statement %d of %s: keep z in range\n"
+             "       and fold it back into y */\n",k,funcName(f));
+      printf("    z[%d] = y - b[%d];\n",k % 10,k % 10);
+      break;
+    case 4:
+      if (f > 0)
+        printf("    z[%d] = %s(x, z);\n",k % 10,funcName(f-1));
+      else
+        printf("    z[%d] = g + x;\n",k % 10);
+      break;
+    case 5:
+      printf("    if (z[%d] >= y) { x = z[%d]; y = x * 2; }\n",k % 10,k % 10);
+      break;
+    default:
+      printf("    g = g + x * y - z[%d];\n",k % 10);
+      break;
+  }
+}
+
+int main( int argc, char * argv[] )
+{ int nfuncs = argc > 1 ? atoi(argv[1]) : 1000;
+  int nstmts = argc > 2 ? atoi(argv[2]) : 100;
+  int f, k;
+  printf("/* generated by gencm %d %d */\n\n",nfuncs,nstmts);
+  printf("int g;\nint garr[100];\n\n");
+  for (f = 0; f < nfuncs; f++)
+  { printf("int %s(int a, int b[])\n{\n",funcName(f));
+    printf("    int x;\n    int y;\n    int z[10];\n");
+    printf("    x = a;\n    y = 0;\n");
+    for (k = 0; k < nstmts; k++)
+      genStatement(f,k);
+    printf("    return x + y;\n}\n\n");
+  }
+  printf("void main(void)\n{\n    g = %s(1, garr);\n}\n",funcName(nfuncs-1));
+  return 0;
+}
@@ -0,0 +1,87 @@
+/****************************************************/
+/* File: lexbench.c                                 */
+/* Parallel chunked scanning against the serial     */
+/* scanner; also checks the token streams match     */
+/* usage: lexbench file [threads]                   */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "scan.h"
+#include "srcmap.h"
+#include "tokbuf.h"
+#include "plex.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* dup copies n elements of a token array */
+static void * dup( const void * p, int n, int size )
+{ void * q = malloc((size_t) n * size);
+  if (q == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  memcpy(q,p,(size_t) n * size);
+  return q;
+}
+
+int main( int argc, char * argv[] )
+{ Compiler cc;
+  short * kind;
+  int * off, * len;
+  int n, i;
+  double ts, tp;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  LexThreads = 4;
+  if (argc != 2 && argc != 3)
+  { fprintf(stderr,"usage: %s <filename> [threads]\n",argv[0]);
+    exit(1);
+  }
+  if (argc == 3) LexThreads = atoi(argv[2]);
+  compilerInit(&cc,argv[1]);
+  if (!mapSource(&cc,argv[1]))
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  ts = now();
+  n = scanAll(&cc);
+  ts = now() - ts;
+  kind = dup(cc.tokKind,n,sizeof(short));
+  off = dup(cc.tokOff,n,sizeof(int));
+  len = dup(cc.tokLen,n,sizeof(int));
+  /* the serial scan used the scanner up, and with
+     one thread scanParallel scans serially: it
+     starts over on the source mapped again */
+  compilerReset(&cc,argv[1]);
+  if (!mapSource(&cc,argv[1]))
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  tp = now();
+  scanParallel(&cc,LexThreads);
+  tp = now() - tp;
+  if (cc.tokCount != n)
+  { printf("token count differs: serial %d, parallel %d\n",n,cc.tokCount);
+    return 1;
+  }
+  for (i = 0; i < n; i++)
+    if (cc.tokKind[i] != kind[i] || cc.tokOff[i] != off[i]
+        || cc.tokLen[i] != len[i])
+    { printf("token %d differs: serial %d@%d+%d, parallel %d@%d+%d\n",
+             i,kind[i],off[i],len[i],cc.tokKind[i],cc.tokOff[i],cc.tokLen[i]);
+      return 1;
+    }
+  printf("serial     %10d tokens %8.3f s %8.2f Mtokens/s\n",n,ts,n/ts/1e6);
+  printf("%2d threads %10d tokens %8.3f s %8.2f Mtokens/s\n",
+         LexThreads,n,tp,n/tp/1e6);
+  compilerFree(&cc);
+  return 0;
+}
@@ -0,0 +1,314 @@
+/****************************************************/
+/* File: outbench.c                                 */
+/* Output benchmark: writes the token trace and the */
+/* syntax tree listing of a file, and a stream of   */
+/* TM instructions, once through fprintf as the     */
+/* compiler used to and once through an Out         */
+/* (out.h), to real files; the bytes must be the    */
+/* same                                             */
+/* usage: outbench file [lines]                     */
+/* exits with 1 if the outputs differ               */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "tokbuf.h"
+#include "util.h"
+#include "parse.h"
+#include "walk.h"
+#include "code.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the tokens of the file, with their lines and
+   lexemes worked out beforehand so that only the
+   printing is timed */
+static int ntokens;
+static int * tokLine;
+static char ** tokText;
+
+/* old is where the fprintf path writes */
+static FILE * old;
+
+/* the token trace, as getToken prints it */
+static void oldTokens( Compiler * cc )
+{ int i;
+  for (i = 0; i < ntokens; i++)
+  { const char * name = tokenName(cc->tokKind[i]);
+    fprintf(old,"\t%d\t\t\t",tokLine[i]);
+    if (name == NULL) fprintf(old,"Unknown token: %d\n",cc->tokKind[i]);
+    else fprintf(old,"%-20s%-20s\n",name,tokText[i]);
+  }
+}
+
+static void newTokens( Compiler * cc )
+{ int i;
+  for (i = 0; i < ntokens; i++)
+  { outChar(cc->listing,'\t');
+    outInt(cc->listing,tokLine[i],0);
+    outStr(cc->listing,"\t\t\t");
+    printToken(cc,cc->tokKind[i],tokText[i]);
+  }
+}
+
+/* oldNode prints a node as printTree did with fprintf */
+static void oldNode( Compiler * cc, TreeNode * t )
+{ int indent = 2 * walkDepth(cc);
+  fprintf(old,"%*s",indent,"");
+  switch (t->nodekind)
+  { case StmtK:
+      switch (t->kind.stmt)
+      { case IfK: fprintf(old,"If\n"); break;
+        case LoopK: fprintf(old,"While\n"); break;
+        case RetK: fprintf(old,"Return\n"); break;
+        case CompK: fprintf(old,"Compound Statement\n"); break;
+        default: fprintf(old,"Unknown ExpNode kind\n"); break;
+      }
+      break;
+    case ExpK:
+      switch (t->kind.exp)
+      { case OpK:
+          switch (t->attr.op)
+          { case PLUS: case MINUS:
+              fprintf(old,"Additive Expression\n"); break;
+            case TIMES: case OVER:
+              fprintf(old,"Multiplicative Expression\n"); break;
+            default:
+              fprintf(old,"Simple Expression\n"); break;
+          }
+          fprintf(old,"%*s  Operator : ",indent,"");
+          switch (t->attr.op)
+          { case LTE: fprintf(old,"<=\n"); break;
+            case LT: fprintf(old,"<\n"); break;
+            case GTE: fprintf(old,">=\n"); break;
+            case GT: fprintf(old,">\n"); break;
+            case EQ: fprintf(old,"==\n"); break;
+            case NEQ: fprintf(old,"!=\n"); break;
+            case PLUS: fprintf(old,"+\n"); break;
+            case MINUS: fprintf(old,"-\n"); break;
+            case TIMES: fprintf(old,"*\n"); break;
+            case OVER: fprintf(old,"/\n"); break;
+            default: fprintf(old,"Not assigned OP token\n"); break;
+          }
+          break;
+        case ConstK: fprintf(old,"Constant : %d\n",t->attr.val); break;
+        case IdK: fprintf(old,"Variable : %s\n",t->attr.name); break;
+        case ArrIdK: fprintf(old,"Array ID : %s\n",t->attr.name); break;
+        case CallK: fprintf(old,"Call to %s\n",t->attr.name); break;
+        case AssignK: fprintf(old,"Assign : =\n"); break;
+        default: fprintf(old,"Unknown ExpNode kind\n"); break;
+      }
+      break;
+    case DeclK:
+      switch (t->kind.decl)
+      { case FuncK: fprintf(old,"Function Declare : %s\n",t->attr.name); break;
+        case VarK: fprintf(old,"Variable Declare : %s\n",t->attr.name); break;
+        case ArrVarK:
+          if (t->attr.arrAttr.size < 0)
+            fprintf(old,"Array Variable Declare : %s\n",t->attr.arrAttr.name);
+          else
+            fprintf(old,"Array Variable Allocate : %s of size %d\n",
+                    t->attr.arrAttr.name,t->attr.arrAttr.size);
+          break;
+        case ParamK: fprintf(old,"Param : %s\n",t->attr.name); break;
+        case ArrParamK: fprintf(old,"Array Param : %s\n",t->attr.name); break;
+        default: fprintf(old,"Unknown Declaration Node Kind\n"); break;
+      }
+      break;
+    case TypeK:
+      if (t->kind.type != TypeNameK)
+        fprintf(old,"Unknown Type Node Kind\n");
+      else if (t->attr.type == INT) fprintf(old,"Type : int\n");
+      else if (t->attr.type == VOID) fprintf(old,"Type : void\n");
+      else fprintf(old,"Type : Unknown Variable Type\n");
+      break;
+    default:
+      fprintf(old,"Unknown node kind\n");
+      break;
+  }
+}
+
+/* the syntax tree of the file */
+static TreeNode * tree;
+
+static void oldTree( Compiler * cc )
+{ walkTree(cc,tree,oldNode,NULL,NULL);
+}
+
+static void newTree( Compiler * cc )
+{ printTree(cc,tree);
+}
+
+/* the TM code: instructions of every form, with
+   comments, a few per line of a made up program */
+static int ninstrs;
+
+static void oldCode( Compiler * cc )
+{ int k;
+  for (k = 0; k < ninstrs; k++)
+    switch (k % 4)
+    { case 0:
+        fprintf(old,"* %s\n","-> Op");
+        fprintf(old,"%3d:  %5s  %d,%d(%d) ",k,"LD",ac,k % 1000 - 500,mp);
+        fprintf(old,"\t%s","op: load left");
+        fprintf(old,"\n");
+        break;
+      case 1:
+        fprintf(old,"%3d:  %5s  %d,%d,%d ",k,"ADD",ac,ac1,ac);
+        fprintf(old,"\t%s","op +");
+        fprintf(old,"\n");
+        break;
+      case 2:
+        fprintf(old,"%3d:  %5s  %d,%d(%d) ",k,"LDA",pc,-k,pc);
+        fprintf(old,"\t%s","jmp to end");
+        fprintf(old,"\n");
+        break;
+      default:
+        fprintf(old,"%3d:  %5s  %d,%d(%d) ",k,"ST",ac,k,gp);
+        fprintf(old,"\t%s","assign: store value");
+        fprintf(old,"\n");
+        fprintf(old,"* %s\n","<- Op");
+        break;
+    }
+}
+
+static void newCode( Compiler * cc )
+{ int k;
+  cc->emitLoc = cc->highEmitLoc = 0;
+  for (k = 0; k < ninstrs; k++)
+    switch (k % 4)
+    { case 0:
+        emitComment(cc,"-> Op");
+        emitRM(cc,"LD",ac,k % 1000 - 500,mp,"op: load left");
+        break;
+      case 1:
+        emitRO(cc,"ADD",ac,ac1,ac,"op +");
+        break;
+      case 2:
+        emitRM_Abs(cc,"LDA",pc,cc->emitLoc + 1 - k,"jmp to end");
+        break;
+      default:
+        emitRM(cc,"ST",ac,k,gp,"assign: store value");
+        emitComment(cc,"<- Op");
+        break;
+    }
+}
+
+/* same tells whether the files a and b hold the same
+   bytes, and returns their length in *len and their
+   lines in *lines */
+static int same( FILE * a, FILE * b, long * len, long * lines )
+{ static char bufA[1 << 16], bufB[1 << 16];
+  size_t n, m, i;
+  *len = *lines = 0;
+  rewind(a);
+  rewind(b);
+  do
+  { n = fread(bufA,1,sizeof(bufA),a);
+    m = fread(bufB,1,sizeof(bufB),b);
+    if (n != m || memcmp(bufA,bufB,n) != 0) return FALSE;
+    *len += n;
+    for (i = 0; i < n; i++) *lines += bufA[i] == '\n';
+  } while (n > 0);
+  return TRUE;
+}
+
+/* run times reps runs of the fprintf path oldProc
+   and of the Out path newProc, each into a file of
+   its own, and reports them; returns FALSE if the
+   files differ */
+static int run( Compiler * cc, const char * name, int reps,
+                void (* oldProc) (Compiler *),
+                void (* newProc) (Compiler *) )
+{ FILE * fnew;
+  Out out;
+  double to, tn;
+  long len, lines;
+  int r, ok;
+  if ((old = tmpfile()) == NULL || (fnew = tmpfile()) == NULL)
+  { fprintf(stderr,"Cannot create temporary files\n");
+    exit(1);
+  }
+  to = now();
+  for (r = 0; r < reps; r++) oldProc(cc);
+  fflush(old);
+  to = now() - to;
+  tn = now();
+  outOpen(&out,fnew);
+  cc->listing = cc->code = &out;
+  for (r = 0; r < reps; r++) newProc(cc);
+  outClose(&out);
+  tn = now() - tn;
+  cc->listing = cc->code = NULL;
+  ok = same(old,fnew,&len,&lines);
+  printf("  %-12s %9ld lines %7.1f MB  fprintf %6.3f s %5.1f ns/line"
+         "  out %6.3f s %5.1f ns/line  %4.2fx  %s\n",
+         name,lines,len / 1e6,to,to / lines * 1e9,
+         tn,tn / lines * 1e9,to / tn,ok ? "same" : "DIFFERENT");
+  fclose(old);
+  fclose(fnew);
+  return ok;
+}
+
+/* the nodes of the tree, counted by countNode */
+static long nodes;
+
+static void countNode( Compiler * cc, TreeNode * t )
+{ nodes++;
+}
+
+int main( int argc, char * argv[] )
+{ long lines = argc > 2 ? atol(argv[2]) : 5000000;
+  Compiler cc;
+  int i, ok = TRUE;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  TraceCode = TRUE;
+  PreTokenize = TRUE;
+  RDParse = TRUE;
+  if (argc < 2 || lines < 1)
+  { fprintf(stderr,"usage: %s file [lines]\n",argv[0]);
+    exit(1);
+  }
+  compilerInit(&cc,argv[1]);
+  if (!mapSource(&cc,argv[1])
+      || (cc.srcFile = srcFileAdd(&cc,argv[1],cc.srcBuf,cc.srcLen)) < 0)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  if ((tree = parse(&cc)) == NULL || cc.Error)
+  { fprintf(stderr,"%s does not parse\n",argv[1]);
+    exit(1);
+  }
+  outFlush(cc.listing);
+  ntokens = cc.tokCount;
+  tokLine = malloc(ntokens * sizeof(int));
+  tokText = malloc(ntokens * sizeof(char *));
+  if (tokLine == NULL || tokText == NULL)
+  { fprintf(stderr,"Out of memory for %d tokens\n",ntokens);
+    exit(1);
+  }
+  for (i = 0; i < ntokens; i++)
+  { tokLine[i] = locLine(&cc,tokLoc(&cc,i));
+    tokText[i] = tokenCopy(&cc,i);
+  }
+  walkTree(&cc,tree,countNode,NULL,NULL);
+  ninstrs = 100000;
+  printf("%s: %d tokens, %ld nodes\n",argv[1],ntokens,nodes);
+  /* each output is repeated to about lines lines */
+  ok &= run(&cc,"token trace",lines / ntokens + 1,oldTokens,newTokens);
+  ok &= run(&cc,"syntax tree",lines / nodes + 1,oldTree,newTree);
+  ok &= run(&cc,"TM code",lines / ninstrs + 1,oldCode,newCode);
+  free(tokLine);
+  free(tokText);
+  compilerFree(&cc);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/****************************************************/
+/* File: parsebench.c                               */
+/* Parser benchmark: parses each file with the      */
+/* Bison parser and with the recursive-descent one, */
+/* checks that the two print the same syntax tree   */
+/* (or syntax error), and reports the time per tree */
+/* node of each, which stays flat as the files grow */
+/* if parsing is linear                             */
+/* usage: parsebench file...                        */
+/* exits with 1 if the parsers disagree on a file   */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "tokbuf.h"
+#include "util.h"
+#include "skip.h"
+#include "rdparse.h"
+#include "intern.h"
+#include "arena.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* countNodes counts the nodes of a syntax tree */
+static long countNodes( TreeNode * t )
+{ long n = 0;
+  int i;
+  for (; t != NULL; t = t->sibling)
+  { n++;
+    for (i = 0; i < MAXCHILDREN; i++)
+      n += countNodes(t->child[i]);
+  }
+  return n;
+}
+
+/* printLocs prints the location of every node of a
+   syntax tree, which printTree leaves out */
+static void printLocs( Out * out, TreeNode * t )
+{ int i;
+  for (; t != NULL; t = t->sibling)
+  { outPrintf(out,"%u\n",t->loc);
+    for (i = 0; i < MAXCHILDREN; i++)
+      printLocs(out,t->child[i]);
+  }
+}
+
+/* PARSEREPS is the number of tokens each parser is
+   timed on at least, parsing small files repeatedly */
+#define PARSEREPS 2000000
+
+/* runParser parses the buffered tokens of cc reps
+ * times with the Bison parser, or with rdParse if rd,
+ * returns the seconds per parse and leaves the tree
+ * and its node locations, or the syntax error,
+ * printed in *out, and the arena bytes it took in
+ * *arena
+ */
+static double runParser( Compiler * cc, int rd, int reps,
+                         char ** out, size_t * outLen, long * nodes,
+                         size_t * arena )
+{ double t = 0;
+  int i;
+  for (i = 0; i < reps; i++)
+  { TreeNode * tree;
+    Out listing;
+    double t0;
+    outOpen(&listing,NULL);
+    cc->listing = &listing;
+    cc->nextTok = 0;
+    cc->curTok = -1;
+    cc->savedTree = NULL;
+    cc->Error = FALSE;
+    t0 = now();
+    if (rd) tree = rdParse(cc);
+    else
+    { yyparse(cc);
+      tree = cc->savedTree;
+    }
+    t += now() - t0;
+    *nodes = countNodes(tree);
+    printTree(cc,tree);
+    printLocs(cc->listing,tree);
+    *out = listing.buf;
+    *outLen = listing.len;
+    cc->listing = NULL;
+    *arena = arenaUsed(cc,NULL);
+    internReset(cc);
+    arenaReset(cc);
+    if (i < reps-1) free(*out);
+  }
+  return t / reps;
+}
+
+int main( int argc, char * argv[] )
+{ int i, differ = 0;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename>...\n",argv[0]);
+    exit(1);
+  }
+  skipSelect(SkipAVX2);
+  for (i = 1; i < argc; i++)
+  { Compiler cc;
+    double tl, ty, tr;
+    long nodes;
+    size_t arena;
+    int reps;
+    char * outY, * outR;
+    size_t lenY, lenR;
+    compilerInit(&cc,argv[i]);
+    if (!mapSource(&cc,argv[i])
+        || (cc.srcFile = srcFileAdd(&cc,argv[i],cc.srcBuf,cc.srcLen)) < 0)
+    { fprintf(stderr,"File %s not found\n",argv[i]);
+      exit(1);
+    }
+    /* scanning is timed on its own, and the parsers
+       then read the token buffer, so that the parse
+       time is the grammar and its actions alone */
+    tl = now();
+    scanAll(&cc);
+    tl = now() - tl;
+    reps = PARSEREPS / cc.tokCount + 1;
+    ty = runParser(&cc,FALSE,reps,&outY,&lenY,&nodes,&arena);
+    tr = runParser(&cc,TRUE,reps,&outR,&lenR,&nodes,&arena);
+    if (nodes == 0) nodes = 1;
+    printf("%-24s %9d tokens %9ld nodes  scan %8.3f s  bison %8.3f s"
+           " %6.1f ns/node  rd %8.3f s %6.1f ns/node  %4.2fx"
+           "  arena %5.1f B/node  %s\n",
+           argv[i],cc.tokCount,nodes,tl,ty,ty/nodes*1e9,tr,tr/nodes*1e9,
+           ty/tr,(double) arena/nodes,
+           lenY == lenR && memcmp(outY,outR,lenY) == 0 ? "same" : "DIFFERENT");
+    if (lenY != lenR || memcmp(outY,outR,lenY) != 0) differ = 1;
+    free(outY);
+    free(outR);
+    compilerFree(&cc);
+  }
+  return differ;
+}
@@ -0,0 +1,43 @@
+/****************************************************/
+/* File: scanbench.c                                */
+/* Scanner throughput benchmark; linked once with   */
+/* each scanner (flex and dfa)                      */
+/* usage: scanbench file                            */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "scan.h"
+#include "srcmap.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main( int argc, char * argv[] )
+{ Compiler cc;
+  long ntokens = 0;
+  double t;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  if (argc != 2)
+  { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+    exit(1);
+  }
+  compilerInit(&cc,argv[1]);
+  if (!mapSource(&cc,argv[1]))
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    exit(1);
+  }
+  t = now();
+  while (getToken(&cc) != ENDFILE) ntokens++;
+  t = now() - t;
+  printf("%-16s %10ld tokens %8.3f s %8.2f Mtokens/s %6.1f MB/s\n",
+         argv[0],ntokens,t,ntokens/t/1e6,cc.srcLen/t/1e6);
+  compilerFree(&cc);
+  return 0;
+}
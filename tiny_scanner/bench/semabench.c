@@ -0,0 +1,206 @@
+/****************************************************/
+/* File: semabench.c                                */
+/* Semantic analysis benchmark: analyzes each file  */
+/* in the single fused traversal of analyze and in  */
+/* the two of buildSymtab and typeCheck, checks     */
+/* that both print the same errors and symbol       */
+/* table, the two passes printing all declaration   */
+/* errors first, so only the order may differ, and  */
+/* reports the time per tree node of each; files of */
+/* many functions are analyzed on 1 to 8 threads as */
+/* well, checking exactly the same is printed and   */
+/* timing each                                      */
+/* usage: semabench file...                         */
+/* exits with 1 if any two disagree on a file       */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "parse.h"
+#include "symtab.h"
+#include "analyze.h"
+#include "walk.h"
+
+#include <time.h>
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the nodes of the tree, counted by countNode */
+static long nodes;
+
+static void countNode( Compiler * cc, TreeNode * t )
+{ nodes++;
+}
+
+/* same tells whether two analyses printed the same */
+static int same( const char * a, size_t lenA, const char * b, size_t lenB )
+{ return lenA == lenB && memcmp(a,b,lenA) == 0;
+}
+
+static int compareLines( const void * a, const void * b )
+{ return strcmp(*(char * const *) a,*(char * const *) b);
+}
+
+/* sortedLines returns the lines of the n bytes at s,
+   copied into *mem, sorted, and their number in
+   *count; free both */
+static char ** sortedLines( const char * s, size_t n, char ** mem, size_t * count )
+{ char ** line;
+  size_t i, k = 1;
+  for (i = 0; i < n; i++)
+    if (s[i] == '\n') k++;
+  *mem = malloc(n + 1);
+  line = malloc(k * sizeof(char *));
+  if (*mem == NULL || line == NULL)
+  { fprintf(stderr,"Out of memory for %lu lines\n",(unsigned long) k);
+    exit(1);
+  }
+  memcpy(*mem,s,n);
+  (*mem)[n] = '\0';
+  line[0] = *mem;
+  for (i = 0, k = 1; i < n; i++)
+    if ((*mem)[i] == '\n')
+    { (*mem)[i] = '\0';
+      line[k++] = *mem + i + 1;
+    }
+  qsort(line,k,sizeof(char *),compareLines);
+  *count = k;
+  return line;
+}
+
+/* reordered tells whether two analyses printed the
+   same lines, in any order */
+static int reordered( const char * a, size_t lenA, const char * b, size_t lenB )
+{ char * memA, * memB, ** lineA, ** lineB;
+  size_t nA, nB, i;
+  int ok;
+  if (lenA != lenB) return FALSE;
+  lineA = sortedLines(a,lenA,&memA,&nA);
+  lineB = sortedLines(b,lenB,&memB,&nB);
+  ok = nA == nB;
+  for (i = 0; ok && i < nA; i++)
+    ok = strcmp(lineA[i],lineB[i]) == 0;
+  free(lineA);
+  free(lineB);
+  free(memA);
+  free(memB);
+  return ok;
+}
+
+/* SEMAREPS is the number of nodes each analysis is
+   timed on at least, analyzing small files repeatedly */
+#define SEMAREPS 20000000
+
+/* files with PARFUNCS functions or more are also
+   analyzed on each number of threads in threads[] */
+#define PARFUNCS 100
+
+static const int threads[] = { 1, 2, 4, 8 };
+
+/* runAnalysis analyzes tree reps times, with analyze
+ * on nthreads threads if fused and with buildSymtab
+ * and typeCheck otherwise, and returns the seconds
+ * per run; then runs it once more, leaving the errors
+ * and the symbol table printed after in *out
+ */
+static double runAnalysis( Compiler * cc, TreeNode * tree, int fused,
+                           int nthreads, int reps,
+                           char ** out, size_t * outLen )
+{ double t = 0;
+  Out listing;
+  int i;
+  outOpen(&listing,NULL);
+  cc->listing = &listing;
+  cc->AnalyzeThreads = nthreads;
+  for (i = 0; i <= reps; i++)
+  { double t0;
+    st_free(cc);
+    cc->location = 0;
+    cc->Error = FALSE;
+    outReset(&listing);
+    t0 = now();
+    if (fused) analyze(cc,tree);
+    else
+    { buildSymtab(cc,tree);
+      typeCheck(cc,tree);
+    }
+    if (i < reps) t += now() - t0;
+  }
+  printSymTab(cc);
+  *out = listing.buf;
+  *outLen = listing.len;
+  cc->listing = &cc->out;
+  return t / reps;
+}
+
+int main( int argc, char * argv[] )
+{ int i, differ = 0;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  RDParse = TRUE;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename>...\n",argv[0]);
+    exit(1);
+  }
+  for (i = 1; i < argc; i++)
+  { Compiler cc;
+    TreeNode * tree, * t;
+    double tf, tt;
+    int reps, funcs, k;
+    char * outF, * outT;
+    size_t lenF, lenT;
+    Out errors;
+    compilerInit(&cc,argv[i]);
+    if (!mapSource(&cc,argv[i])
+        || (cc.srcFile = srcFileAdd(&cc,argv[i],cc.srcBuf,cc.srcLen)) < 0)
+    { fprintf(stderr,"File %s not found\n",argv[i]);
+      exit(1);
+    }
+    /* the syntax errors are not wanted */
+    outOpen(&errors,NULL);
+    cc.listing = &errors;
+    tree = parse(&cc);
+    outClose(&errors);
+    cc.listing = &cc.out;
+    if (tree == NULL || cc.Error)
+    { printf("%-24s does not parse\n",argv[i]);
+      compilerFree(&cc);
+      continue;
+    }
+    nodes = 0;
+    walkTree(&cc,tree,countNode,NULL,NULL);
+    for (funcs = 0, t = tree; t != NULL; t = t->sibling)
+      if (t->nodekind == DeclK && t->kind.decl == FuncK) funcs++;
+    reps = SEMAREPS / nodes + 1;
+    tt = runAnalysis(&cc,tree,FALSE,1,reps,&outT,&lenT);
+    tf = runAnalysis(&cc,tree,TRUE,1,reps,&outF,&lenF);
+    printf("%-24s %9ld nodes  two passes %8.4f s %6.1f ns/node"
+           "  fused %8.4f s %6.1f ns/node  %4.2fx  %s\n",
+           argv[i],nodes,tt,tt/nodes*1e9,tf,tf/nodes*1e9,tt/tf,
+           same(outF,lenF,outT,lenT) ? "same"
+           : reordered(outF,lenF,outT,lenT) ? "same, reordered" : "DIFFERENT");
+    if (!reordered(outF,lenF,outT,lenT)) differ = 1;
+    for (k = 0; funcs >= PARFUNCS && k < (int) (sizeof(threads) / sizeof(threads[0])); k++)
+    { char * outP;
+      size_t lenP;
+      double tp = runAnalysis(&cc,tree,TRUE,threads[k],reps,&outP,&lenP);
+      printf("%-24s %9d funcs  %d thread%s %8.4f s %6.1f ns/node  %4.2fx  %s\n",
+             "",funcs,threads[k],threads[k] == 1 ? " " : "s",
+             tp,tp/nodes*1e9,tf/tp,
+             same(outP,lenP,outF,lenF) ? "same" : "DIFFERENT");
+      if (!same(outP,lenP,outF,lenF)) differ = 1;
+      free(outP);
+    }
+    free(outF);
+    free(outT);
+    compilerFree(&cc);
+  }
+  return differ;
+}
@@ -0,0 +1,124 @@
+/****************************************************/
+/* File: skipbench.c                                */
+/* Benchmark of the vectorized blank and comment    */
+/* skipping against the character-at-a-time walk    */
+/* usage: skipbench [megabytes]                     */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "skip.h"
+
+/* genSource fills buf with text shaped like our
+ * generated C- inputs: deeply indented statements,
+ * blank lines, and a long block comment every few
+ * statements
+ */
+static int genSource(char * buf, int len)
+{ int n = 0, stmt = 0;
+  while (n < len - 1024)
+  { int i;
+    if (stmt % 4 == 0)
+    { n += sprintf(buf+n,"\n                /*");
+      for (i = 0; i < 8; i++)
+        n += sprintf(buf+n," * generated from rule %6d, template line %d,"
+                     " do not edit by hand\n                ",stmt,i);
+      n += sprintf(buf+n," */\n");
+    }
+    n += sprintf(buf+n,"\n                        x%c = y%c + %d;    \n",
+                 'a'+stmt%26,'a'+stmt%26,stmt);
+    stmt++;
+  }
+  buf[n] = '\0';
+  return n;
+}
+
+/* rulesWalk is the character-at-a-time baseline:
+ * one step per byte of blanks and comment text, as
+ * the {whitespace}, {newline} and <C_COMMENT> rules
+ * take (flex adds a DFA transition and an action
+ * dispatch to every one of those steps)
+ */
+static int rulesWalk(const char * p, const char * end)
+{ int comments = 0, inComment = 0;
+  while (p < end)
+  { if (inComment)
+    { if (*p == '*' && p+1 < end && p[1] == '/') { inComment = 0; p++; }
+    }
+    else if (*p == '/' && p+1 < end && p[1] == '*')
+    { inComment = 1;
+      comments++;
+      p++;
+    }
+    p++;
+  }
+  return comments;
+}
+
+#define ISBLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+/* skipWalk is the same walk using skipBlanks and
+ * skipComment; token text in between is stepped
+ * over as the scanner would match it
+ */
+static int skipWalk(const char * p, const char * end)
+{ int comments = 0;
+  while (p < end)
+  { p = skipBlanks(p,end);
+    if (p >= end) break;
+    if (*p == '/' && p+1 < end && p[1] == '*')
+    { comments++;
+      p = skipComment(p+2,end);
+      if (p == NULL) break;
+    }
+    else
+      do p++; while (p < end && !ISBLANK(*p) && *p != '/');
+  }
+  return comments;
+}
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main( int argc, char * argv[] )
+{ static const char * names[] = { "scalar", "sse2", "avx2" };
+  int mb = argc > 1 ? atoi(argv[1]) : 64;
+  int len = mb << 20, reps = 5, r, comments, expect;
+  char * buf = malloc(len+1);
+  double t, best;
+  SkipLevel level;
+  if (buf == NULL) return 1;
+  len = genSource(buf,len);
+
+  best = 1e30;
+  for (r = 0; r < reps; r++)
+  { t = now();
+    expect = rulesWalk(buf,buf+len);
+    t = now() - t;
+    if (t < best) best = t;
+  }
+  printf("%-8s %8.1f MB/s  %d comments\n","rules",len/best/1e6,expect);
+
+  for (level = SkipScalar; level <= SkipAVX2; level++)
+  { if (skipSelect(level) != level)
+    { printf("%-8s unsupported on this CPU\n",names[level]);
+      continue;
+    }
+    best = 1e30;
+    for (r = 0; r < reps; r++)
+    { t = now();
+      comments = skipWalk(buf,buf+len);
+      t = now() - t;
+      if (t < best) best = t;
+    }
+    printf("%-8s %8.1f MB/s  %d comments%s\n",names[level],len/best/1e6,
+           comments,comments == expect ? "" : "  MISMATCH");
+  }
+  free(buf);
+  return 0;
+}
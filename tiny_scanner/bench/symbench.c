@@ -0,0 +1,304 @@
+/****************************************************/
+/* File: symbench.c                                 */
+/* Symbol table benchmark: declares and looks up    */
+/* ever more names, in the symbol table and in the  */
+/* 211-bucket chained table it used to be; then     */
+/* opens scopes nested ever deeper, each declaring  */
+/* a name that hides the one outside it, and times  */
+/* entering and exiting the scopes and looking      */
+/* names up at the innermost one, which must not    */
+/* grow with the depth; and records, reads back and */
+/* prints ever more references, against the line    */
+/* lists it used to keep                            */
+/* usage: symbench                                  */
+/* exits with 1 if a lookup finds the wrong symbol  */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "intern.h"
+#include "arena.h"
+#include "symtab.h"
+#include "srcloc.h"
+
+#include <time.h>
+
+/* each lookup is timed over LOOKUPS lookups */
+#define LOOKUPS 10000000
+
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* name returns the atom of prefix followed by k */
+static Atom name( Compiler * cc, const char * prefix, int k )
+{ char buf[32];
+  int n = snprintf(buf,sizeof(buf),"%s%d",prefix,k);
+  return intern(cc,buf,n);
+}
+
+/* names returns the atoms v0 .. v<n-1> */
+static Atom * names( Compiler * cc, int n )
+{ Atom * v = malloc(n * sizeof(Atom));
+  int k;
+  if (v == NULL)
+  { fprintf(stderr,"Out of memory for %d names\n",n);
+    exit(1);
+  }
+  for (k = 0; k < n; k++) v[k] = name(cc,"v",k);
+  return v;
+}
+
+/* the chained table the symbol table used to be:
+   SIZE buckets, each name added at the front of
+   its bucket after a search for it */
+#define SIZE 211
+
+typedef struct ChainRec
+   { Atom name;
+     int offset;
+     struct ChainRec * next;
+   } ChainRec;
+
+static ChainRec * chain[SIZE];
+
+static ChainRec * chainFind( Atom name )
+{ ChainRec * l = chain[atomHash(name) % SIZE];
+  while ((l != NULL) && (name != l->name))
+    l = l->next;
+  return l;
+}
+
+static void chainInsert( Compiler * cc, Atom name, int offset )
+{ if (chainFind(name) == NULL)
+  { ChainRec * l = arenaAlloc(cc,sizeof(ChainRec));
+    int h = atomHash(name) % SIZE;
+    l->name = name;
+    l->offset = offset;
+    l->next = chain[h];
+    chain[h] = l;
+  }
+}
+
+/* table declares n global names, then looks them up
+   in a scattered order, in the symbol table and in
+   the chained table; the chained one only looks up
+   as many as take about as long as the rest, and
+   skips inserting if that would take minutes.
+   Returns FALSE if a lookup is wrong */
+static int table( Compiler * cc, int n )
+{ Atom * v = names(cc,n);
+  double ti, tl, ci = 0, cl;
+  volatile int sink = 0;
+  int k, m, i, ok = TRUE;
+  /* a stride prime to n visits every name once */
+  int step = 7919 % n ? 7919 : 7907;
+  ti = now();
+  for (k = 0; k < n; k++) st_declare(cc,v[k],VarK,Integer,-1,k,NULL);
+  ti = now() - ti;
+  tl = now();
+  for (k = 0, i = 0; k < LOOKUPS; k++, i = (i + step) % n)
+    sink += st_find(cc,v[i])->offset;
+  tl = now() - tl;
+  for (k = 0, i = 0; k < n; k++, i = (i + step) % n)
+    if (st_find(cc,v[i])->offset != i) ok = FALSE;
+  memset(chain,0,sizeof(chain));
+  if (n <= 100000)
+  { ci = now();
+    for (k = 0; k < n; k++) chainInsert(cc,v[k],k);
+    ci = now() - ci;
+  }
+  else
+    for (k = 0; k < n; k++)
+    { ChainRec * l = arenaAlloc(cc,sizeof(ChainRec));
+      int h = atomHash(v[k]) % SIZE;
+      l->name = v[k];
+      l->offset = k;
+      l->next = chain[h];
+      chain[h] = l;
+    }
+  m = (double) n * n > 1e15 / LOOKUPS ? (int) (1e15 / ((double) n * n))
+                                      : LOOKUPS;
+  cl = now();
+  for (k = 0, i = 0; k < m; k++, i = (i + step) % n)
+    sink += chainFind(v[i])->offset;
+  cl = now() - cl;
+  printf("%8d names  insert %6.1f ns  lookup %6.1f ns"
+         "   chained: insert ",n,ti/n*1e9,tl/LOOKUPS*1e9);
+  if (ci > 0) printf("%8.1f ns",ci/n*1e9);
+  else printf("%8s   ","-");
+  printf("  lookup %8.1f ns  %s\n",cl/m*1e9,ok ? "ok" : "WRONG");
+  free(v);
+  return ok;
+}
+
+/* the references of refs go to SYMS symbols in turn,
+   one on each line of LINE bytes */
+#define SYMS 10
+#define LINE 8
+
+/* the way the symbol table used to record them: a
+   list of line numbers for each symbol, walked to
+   its end to add one */
+typedef struct LineRec
+   { int lineno;
+     struct LineRec * next;
+   } LineRec;
+
+static LineRec * lines[SYMS];
+
+static void oldReference( Compiler * cc, int sym, int lineno )
+{ LineRec * n = arenaAlloc(cc,sizeof(LineRec));
+  n->lineno = lineno;
+  n->next = NULL;
+  if (lines[sym] == NULL) lines[sym] = n;
+  else
+  { LineRec * t = lines[sym];
+    while (t->next != NULL) t = t->next;
+    t->next = n;
+  }
+}
+
+/* refs records n references to SYMS symbols, one on
+   each line of a made up source, reads them back,
+   looks up which symbol is at scattered locations,
+   and prints the table, checking what it reads and
+   looks up, and does the recording the old way too,
+   if that would not take minutes. Returns FALSE if
+   something is wrong */
+static int refs( Compiler * cc, int n )
+{ char * text = malloc((size_t) n * LINE);
+  Symbol * s[SYMS];
+  double tr, tb, ta, tp, to = 0;
+  long bytes = 0;
+  int k, i, file, ok = TRUE;
+  int step = 7919 % n ? 7919 : 7907;
+  Out out;
+  if (text == NULL)
+  { fprintf(stderr,"Out of memory for %d lines\n",n);
+    exit(1);
+  }
+  for (k = 0; k < n; k++)
+  { memset(text + (size_t) k * LINE,' ',LINE - 1);
+    text[(size_t) k * LINE + LINE - 1] = '\n';
+  }
+  file = srcFileAdd(cc,"refs",text,n * LINE);
+  for (i = 0; i < SYMS; i++)
+    s[i] = st_declare(cc,name(cc,"v",i),VarK,Integer,-1,i,NULL);
+  tr = now();
+  for (k = 0; k < n; k++)
+    st_reference(cc,s[k % SYMS],makeLoc(file,k * LINE));
+  tr = now() - tr;
+  tb = now();
+  for (i = 0; i < SYMS; i++)
+  { RefCursor c;
+    SrcLoc at;
+    const RefBlock * b;
+    st_firstRef(s[i],&c);
+    for (k = i; st_nextRef(&c,&at); k += SYMS)
+      if (at != makeLoc(file,k * LINE)) ok = FALSE;
+    if (k - SYMS != i + (s[i]->refCount - 1) * SYMS) ok = FALSE;
+    for (b = s[i]->refs; b != NULL; b = b->next)
+      bytes += sizeof(RefBlock) + b->size;
+  }
+  tb = now() - tb;
+  ta = now();
+  for (k = 0, i = 0; k < LOOKUPS / 10; k++, i = (i + step) % n)
+    if (st_symbolAt(cc,makeLoc(file,i * LINE + 3)) != s[i % SYMS]) ok = FALSE;
+  ta = now() - ta;
+  outOpen(&out,NULL);
+  cc->listing = &out;
+  tp = now();
+  printSymTab(cc);
+  tp = now() - tp;
+  outClose(&out);
+  cc->listing = &cc->out;
+  if (n <= 100000)
+  { memset(lines,0,sizeof(lines));
+    to = now();
+    for (k = 0; k < n; k++) oldReference(cc,k % SYMS,k + 1);
+    to = now() - to;
+  }
+  printf("%8d refs  record %5.1f ns  read %5.1f ns  %4.1f bytes"
+         "  symbol at %6.1f ns  print %5.1f ns   listed: record ",
+         n,tr/n*1e9,tb/n*1e9,(double) bytes/n,ta/(LOOKUPS/10)*1e9,tp/n*1e9);
+  if (to > 0) printf("%8.1f ns",to/n*1e9);
+  else printf("%8s   ","-");
+  printf("  %s\n",ok ? "ok" : "WRONG");
+  free(text);
+  return ok;
+}
+
+/* nest opens depth scopes one inside the other, each
+   declaring x, hiding the x outside it, and a name of
+   its own, looks x and a global up at the innermost
+   one and exits them all, checking that x is the x
+   of each scope it gets back to; returns FALSE if a
+   lookup is wrong */
+static int nest( Compiler * cc, int depth )
+{ Atom x = intern(cc,"x",1), g = intern(cc,"g",1);
+  Atom * own = names(cc,depth);
+  double te, tx, tl, tg;
+  volatile int sink = 0;
+  int k, ok = TRUE;
+  st_declare(cc,g,VarK,Integer,-1,-1,NULL);
+  st_declare(cc,x,VarK,Integer,-1,0,NULL);
+  te = now();
+  for (k = 1; k <= depth; k++)
+  { st_enterScope(cc);
+    st_declare(cc,x,VarK,Integer,-1,k,NULL);
+    st_declare(cc,own[k-1],VarK,Integer,-1,k,NULL);
+  }
+  te = now() - te;
+  ok = ok && st_depth(cc) == depth
+       && st_declare(cc,x,VarK,Integer,-1,0,NULL) == NULL;
+  tl = now();
+  for (k = 0; k < LOOKUPS; k++) sink += st_find(cc,x)->offset;
+  tl = now() - tl;
+  tg = now();
+  for (k = 0; k < LOOKUPS; k++) sink += st_find(cc,g)->offset;
+  tg = now() - tg;
+  ok = ok && st_find(cc,x)->offset == depth && st_find(cc,g)->scope == 0;
+  tx = now();
+  for (k = depth; k > 0; k--)
+  { st_exitScope(cc);
+    if (st_find(cc,x)->offset != k - 1 || st_find(cc,own[k-1]) != NULL)
+      ok = FALSE;
+  }
+  tx = now() - tx;
+  printf("%8d deep  enter %6.1f ns/scope  exit %6.1f ns/scope"
+         "  lookup inner %5.1f ns  global %5.1f ns  %s\n",
+         depth,te/depth*1e9,tx/depth*1e9,tl/LOOKUPS*1e9,tg/LOOKUPS*1e9,
+         ok ? "ok" : "WRONG");
+  free(own);
+  return ok;
+}
+
+int main( int argc, char * argv[] )
+{ static const int sizes[] = { 1000, 100000, 1000000 };
+  static const int counts[] = { 1000, 100000, 1000000 };
+  static const int depths[] = { 10, 1000, 100000, 1000000 };
+  int i, ok = TRUE;
+  Compiler cc;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  compilerInit(&cc,"symbench");
+  for (i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++)
+  { ok &= table(&cc,sizes[i]);
+    compilerReset(&cc,"symbench");
+  }
+  for (i = 0; i < (int) (sizeof(counts) / sizeof(counts[0])); i++)
+  { ok &= refs(&cc,counts[i]);
+    compilerReset(&cc,"symbench");
+  }
+  for (i = 0; i < (int) (sizeof(depths) / sizeof(depths[0])); i++)
+  { ok &= nest(&cc,depths[i]);
+    compilerReset(&cc,"symbench");
+  }
+  compilerFree(&cc);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/****************************************************/
+/* File: treebench.c                                */
+/* Syntax tree benchmark: parses each file, copies  */
+/* the tree into a flat tree, and compares the two  */
+/* in bytes per node and in the time of a full      */
+/* traversal and of printing; the printed trees     */
+/* must be the same                                 */
+/* usage: treebench file...                         */
+/* exits with 1 if the printed trees differ         */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "tokbuf.h"
+#include "util.h"
+#include "skip.h"
+#include "parse.h"
+#include "flat.h"
+
+#include <time.h>
+
+/* each traversal is timed over at least WALKNODES
+   nodes, walking small trees repeatedly */
+#define WALKNODES 20000000
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the traversals compute a checksum of the kinds,
+   locations and payloads of the nodes */
+static unsigned long sum;
+
+/* traverse is traverse in analyze.c */
+static void traverse( Compiler * cc, TreeNode * t,
+               void (* preProc) (Compiler *, TreeNode *),
+               void (* postProc) (Compiler *, TreeNode *) )
+{ if (t != NULL)
+  { preProc(cc,t);
+    { int i;
+      for (i=0; i < MAXCHILDREN; i++)
+        traverse(cc,t->child[i],preProc,postProc);
+    }
+    postProc(cc,t);
+    traverse(cc,t->sibling,preProc,postProc);
+  }
+}
+
+static void treePre( Compiler * cc, TreeNode * t )
+{ sum += t->nodekind * 8 + t->kind.exp + t->loc;
+}
+
+static void treePost( Compiler * cc, TreeNode * t )
+{ if (t->nodekind == ExpK && t->kind.exp == ConstK) sum += t->attr.val;
+}
+
+static void flatPre( Compiler * cc, FlatTree * f, int n )
+{ sum += f->nodekind[n] * 8 + f->kind[n] + f->loc[n];
+}
+
+static void flatPost( Compiler * cc, FlatTree * f, int n )
+{ if (f->nodekind[n] == ExpK && f->kind[n] == ConstK) sum += f->attr[n];
+}
+
+/* printed returns the time to print the tree, or the
+   flat tree if t is NULL, and leaves it in *out */
+static double printed( Compiler * cc, TreeNode * t, FlatTree * f,
+                       char ** out, size_t * len )
+{ double t0;
+  Out listing;
+  outOpen(&listing,NULL);
+  cc->listing = &listing;
+  t0 = now();
+  if (t != NULL) printTree(cc,t);
+  else flatPrintTree(cc,f);
+  t0 = now() - t0;
+  /* the buffer is the caller's to free */
+  *out = listing.buf;
+  *len = listing.len;
+  cc->listing = NULL;
+  return t0;
+}
+
+int main( int argc, char * argv[] )
+{ int i, differ = 0;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  RDParse = TRUE;
+  FlatAST = TRUE;
+  if (argc < 2)
+  { fprintf(stderr,"usage: %s <filename>...\n",argv[0]);
+    exit(1);
+  }
+  skipSelect(SkipAVX2);
+  for (i = 1; i < argc; i++)
+  { Compiler cc;
+    TreeNode * tree;
+    FlatTree * f;
+    double tf, tt, tw, tl, pt, pf;
+    unsigned long treeSum, flatSum, lineSum;
+    char * outT, * outF;
+    size_t lenT, lenF;
+    Out err;
+    int reps, r, n;
+    compilerInit(&cc,argv[i]);
+    if (!mapSource(&cc,argv[i])
+        || (cc.srcFile = srcFileAdd(&cc,argv[i],cc.srcBuf,cc.srcLen)) < 0)
+    { fprintf(stderr,"File %s not found\n",argv[i]);
+      exit(1);
+    }
+    /* syntax errors go to stderr */
+    outOpen(&err,stderr);
+    cc.listing = &err;
+    tree = parse(&cc);
+    outClose(&err);
+    if (tree == NULL)
+    { compilerFree(&cc);
+      continue;
+    }
+    tf = now();
+    f = flatten(&cc,tree);
+    tf = now() - tf;
+    reps = WALKNODES / f->count + 1;
+    /* the TreeNode tree, walked by pointers */
+    sum = 0;
+    tt = now();
+    for (r = 0; r < reps; r++) traverse(&cc,tree,treePre,treePost);
+    tt = now() - tt;
+    treeSum = sum;
+    /* the flat tree, walked by child and sibling */
+    sum = 0;
+    tw = now();
+    for (r = 0; r < reps; r++) flatTraverse(&cc,f,0,flatPre,flatPost);
+    tw = now() - tw;
+    flatSum = sum;
+    /* the flat tree scanned in preorder, for passes
+       that need no parent-child order */
+    sum = 0;
+    tl = now();
+    for (r = 0; r < reps; r++)
+      for (n = 0; n < f->count; n++)
+      { sum += f->nodekind[n] * 8 + f->kind[n] + f->loc[n];
+        if (f->nodekind[n] == ExpK && f->kind[n] == ConstK) sum += f->attr[n];
+      }
+    tl = now() - tl;
+    lineSum = sum;
+    pt = printed(&cc,tree,NULL,&outT,&lenT);
+    pf = printed(&cc,NULL,f,&outF,&lenF);
+    printf("%s: %d nodes, flattened in %.3f s\n",argv[i],f->count,tf);
+    printf("  bytes/node   TreeNode %5.1f   flat %5.1f\n",
+           (double) sizeof(TreeNode),(double) flatBytes(f) / f->count);
+    printf("  ns/node      traverse %5.2f   flatTraverse %5.2f"
+           "   preorder scan %5.2f\n",
+           tt/reps/f->count*1e9,tw/reps/f->count*1e9,tl/reps/f->count*1e9);
+    printf("  printTree    %8.3f s    flatPrintTree %8.3f s   %s\n",pt,pf,
+           lenT == lenF && memcmp(outT,outF,lenT) == 0
+           && treeSum == flatSum && flatSum == lineSum ? "same" : "DIFFERENT");
+    if (lenT != lenF || memcmp(outT,outF,lenT) != 0
+        || treeSum != flatSum || flatSum != lineSum) differ = 1;
+    free(outT);
+    free(outF);
+    compilerFree(&cc);
+  }
+  return differ;
+}
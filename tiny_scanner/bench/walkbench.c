@@ -0,0 +1,209 @@
+/****************************************************/
+/* File: walkbench.c                                */
+/* Tree walk benchmark: builds syntax trees nested  */
+/* and chained millions of nodes deep, walks,       */
+/* prints, flattens and walks them flat, and        */
+/* compares walkTree with a recursive walk on the   */
+/* trees the recursive one can handle               */
+/* usage: walkbench [nodes]                         */
+/* exits with 1 if a walk misses or repeats a node  */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "util.h"
+#include "arena.h"
+#include "flat.h"
+#include "walk.h"
+
+#include <time.h>
+
+/* the recursive walk is only timed, and the tree only
+   printed, on trees this deep or less: the one to stay
+   well inside the C stack, the other because each
+   line is indented as deep as the node is */
+#define MAXRECURSE 10000
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the walks count the nodes and sum their values, in
+   preorder and in postorder */
+static long pre, post;
+static unsigned long sum;
+
+/* traverse is the recursive walk analyze.c had */
+static void traverse( Compiler * cc, TreeNode * t,
+               void (* preProc) (Compiler *, TreeNode *),
+               void (* postProc) (Compiler *, TreeNode *) )
+{ if (t != NULL)
+  { preProc(cc,t);
+    { int i;
+      for (i=0; i < MAXCHILDREN; i++)
+        traverse(cc,t->child[i],preProc,postProc);
+    }
+    postProc(cc,t);
+    traverse(cc,t->sibling,preProc,postProc);
+  }
+}
+
+static void countPre( Compiler * cc, TreeNode * t )
+{ pre++;
+  sum = sum * 31 + (t->nodekind == ExpK && t->kind.exp == ConstK
+                    ? t->attr.val : t->kind.exp);
+}
+
+static void countPost( Compiler * cc, TreeNode * t )
+{ post++;
+  sum = sum * 37 + (t->nodekind == ExpK && t->kind.exp == ConstK
+                    ? t->attr.val : t->kind.exp);
+}
+
+static void flatPre( Compiler * cc, FlatTree * f, int n )
+{ pre++;
+  sum = sum * 31 + (f->nodekind[n] == ExpK && f->kind[n] == ConstK
+                    ? f->attr[n] : f->kind[n]);
+}
+
+static void flatPost( Compiler * cc, FlatTree * f, int n )
+{ post++;
+  sum = sum * 37 + (f->nodekind[n] == ExpK && f->kind[n] == ConstK
+                    ? f->attr[n] : f->kind[n]);
+}
+
+/* constant returns a ConstK node holding v */
+static TreeNode * constant( Compiler * cc, int v )
+{ TreeNode * t = newExpNode(cc,ConstK,0);
+  t->attr.val = v;
+  return t;
+}
+
+/* chain returns n statements one after the other:
+   if (k) k; for k = 0 .. n-1 */
+static TreeNode * chain( Compiler * cc, int n )
+{ TreeNode * first = NULL, * last = NULL;
+  int k;
+  for (k = 0; k < n; k++)
+  { TreeNode * t = newStmtNode(cc,IfK,0);
+    t->child[0] = constant(cc,k);
+    t->child[1] = constant(cc,k);
+    if (last == NULL) first = t;
+    else last->sibling = t;
+    last = t;
+  }
+  return first;
+}
+
+/* nest returns n statements each inside the then part
+   of the one before: if (0) if (1) ... k */
+static TreeNode * nest( Compiler * cc, int n )
+{ TreeNode * top = NULL, * in = NULL;
+  int k;
+  for (k = 0; k < n; k++)
+  { TreeNode * t = newStmtNode(cc,IfK,0);
+    t->child[0] = constant(cc,k);
+    if (in == NULL) top = t;
+    else in->child[1] = t;
+    in = t;
+  }
+  in->child[1] = constant(cc,n);
+  return top;
+}
+
+/* expr returns 0 + 1 + ... + n, nested to the left
+   as the parser builds it */
+static TreeNode * expr( Compiler * cc, int n )
+{ TreeNode * e = constant(cc,0);
+  int k;
+  for (k = 1; k <= n; k++)
+  { TreeNode * t = newExpNode(cc,OpK,0);
+    t->attr.op = PLUS;
+    t->child[0] = e;
+    t->child[1] = constant(cc,k);
+    e = t;
+  }
+  return e;
+}
+
+/* run walks, prints and flattens tree, which has
+   nodes nodes and is depth deep; returns FALSE if a
+   walk does not visit each node once */
+static int run( Compiler * cc, const char * name, TreeNode * tree,
+                long nodes, int depth )
+{ double tw, tr = 0, tp = 0, tf, tt;
+  unsigned long walkSum, recSum = 0;
+  Out * saved = cc->listing;
+  Out listing;
+  FlatTree * f;
+  int ok;
+  pre = post = 0; sum = 0;
+  tw = now();
+  walkTree(cc,tree,countPre,NULL,countPost);
+  tw = now() - tw;
+  walkSum = sum;
+  ok = pre == nodes && post == nodes;
+  if (depth <= MAXRECURSE)
+  { sum = 0;
+    tr = now();
+    traverse(cc,tree,countPre,countPost);
+    tr = now() - tr;
+    recSum = sum;
+    ok = ok && recSum == walkSum;
+    outOpen(&listing,NULL);
+    cc->listing = &listing;
+    tp = now();
+    printTree(cc,tree);
+    tp = now() - tp;
+    outClose(&listing);
+    cc->listing = saved;
+  }
+  tf = now();
+  f = flatten(cc,tree);
+  tf = now() - tf;
+  pre = post = 0; sum = 0;
+  tt = now();
+  flatTraverse(cc,f,0,flatPre,flatPost);
+  tt = now() - tt;
+  ok = ok && f->count == nodes && pre == nodes && post == nodes
+       && sum == walkSum;
+  printf("%-6s %9ld nodes %9d deep  walkTree %5.1f ns/node",
+         name,nodes,depth,tw/nodes*1e9);
+  if (depth <= MAXRECURSE)
+    printf("  recursive %5.1f ns/node",tr/nodes*1e9);
+  else printf("  recursive     -        ");
+  if (depth <= MAXRECURSE) printf("  print %5.2f s",tp);
+  else printf("  print    -   ");
+  printf("  flatten %5.2f s  flatTraverse %5.1f ns/node  %s\n",
+         tf,tt/nodes*1e9,ok ? "ok" : "WRONG");
+  printf("       walk stack %d frames\n",cc->walk->cap);
+  return ok;
+}
+
+int main( int argc, char * argv[] )
+{ int n = argc > 1 ? atoi(argv[1]) : 2000000;
+  int small = n < MAXRECURSE ? n : MAXRECURSE - 1;
+  int ok = TRUE;
+  Compiler cc;
+  Out err;
+  /* the flags this bench changes from flags.c */
+  TraceParse = FALSE;
+  PreTokenize = TRUE;
+  if (n < 1)
+  { fprintf(stderr,"usage: %s [nodes]\n",argv[0]);
+    exit(1);
+  }
+  compilerInit(&cc,"walkbench");
+  outOpen(&err,stderr);
+  cc.listing = &err;
+  ok &= run(&cc,"chain",chain(&cc,n),3L*n,2);
+  ok &= run(&cc,"nest",nest(&cc,small),2L*small+1,small+1);
+  ok &= run(&cc,"nest",nest(&cc,n),2L*n+1,n+1);
+  ok &= run(&cc,"expr",expr(&cc,small),2L*small+1,small+1);
+  ok &= run(&cc,"expr",expr(&cc,n),2L*n+1,n+1);
+  outClose(&err);
+  compilerFree(&cc);
+  return ok ? 0 : 1;
+}
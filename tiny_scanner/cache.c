@@ -0,0 +1,289 @@
+/****************************************************/
+/* File: cache.c                                    */
+/* Content-addressed on-disk cache of compilations  */
+/* Each entry is one file <key>.cmc in the cache    */
+/* directory; its modification time is its last use */
+/****************************************************/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "globals.h"
+#include "cache.h"
+
+/* an entry file starts with this line */
+#define ENTRYMAGIC "CMC1"
+
+/* when over its cap the cache is trimmed to
+ * TRIMPERCENT percent of it, so trimming is rare
+ */
+#define TRIMPERCENT 90
+
+struct cache
+   { char * dir;
+     long long maxBytes;
+     long long bytes;        /* estimated size on disk; -1 until scanned */
+     int hits, misses, stores, evictions;
+     unsigned tmpCount;      /* names temporary files */
+     pthread_mutex_t lock;   /* guards all of the above */
+   };
+
+/**************************************************/
+/***********   keys                    ************/
+/**************************************************/
+
+/* FNV-1a over 128 bits: the prime is 2^88 + 0x13B,
+   so the multiply is a shift and a small product */
+typedef unsigned __int128 Hash128;
+
+static Hash128 hashBytes( Hash128 h, const void * p, size_t n )
+{ const unsigned char * s = p;
+  size_t i;
+  for (i = 0; i < n; i++)
+  { h ^= s[i];
+    h = (h << 88) + h * 0x13B;
+  }
+  return h;
+}
+
+/* Procedure cacheKey computes the key of compiling
+ * the len bytes of src, the file named pgm, with the
+ * output-affecting flags in flags
+ */
+void cacheKey( CacheKey * key, const char * pgm, unsigned flags,
+               const char * src, int len )
+{ Hash128 h = ((Hash128) 0x6c62272e07bb0142ull << 64) | 0x62b821756295c58dull;
+  h = hashBytes(h,COMPILER_VERSION,sizeof(COMPILER_VERSION));
+  h = hashBytes(h,pgm,strlen(pgm)+1);
+  h = hashBytes(h,&flags,sizeof(flags));
+  h = hashBytes(h,src,len);
+  key->hi = (unsigned long long) (h >> 64);
+  key->lo = (unsigned long long) h;
+}
+
+/* entryName returns the path of the entry for key */
+static char * entryName( Cache * c, const CacheKey * key )
+{ char * name = malloc(strlen(c->dir) + 38);
+  if (name == NULL)
+  { fprintf(stderr,"Out of memory for the cache\n");
+    exit(1);
+  }
+  sprintf(name,"%s/%016llx%016llx.cmc",c->dir,key->hi,key->lo);
+  return name;
+}
+
+/**************************************************/
+/***********   eviction                ************/
+/**************************************************/
+
+typedef struct
+   { char * name;
+     long long size;
+     time_t used;
+   } FileRec;
+
+static int byUse( const void * a, const void * b )
+{ time_t x = ((const FileRec *) a)->used, y = ((const FileRec *) b)->used;
+  return x < y ? -1 : x > y;
+}
+
+/* trim measures the cache directory and, if it is
+   over the cap, removes the least recently used
+   entries; called with c->lock held */
+static void trim( Cache * c )
+{ DIR * d = opendir(c->dir);
+  struct dirent * de;
+  FileRec * files = NULL;
+  int n = 0, cap = 0, i;
+  long long total = 0;
+  if (d == NULL) return;
+  while ((de = readdir(d)) != NULL)
+  { size_t len = strlen(de->d_name);
+    struct stat st;
+    char * path;
+    if (len < 4 || strcmp(de->d_name+len-4,".cmc") != 0) continue;
+    path = malloc(strlen(c->dir) + len + 2);
+    if (path == NULL) break;
+    sprintf(path,"%s/%s",c->dir,de->d_name);
+    if (stat(path,&st) < 0)
+    { free(path);
+      continue;
+    }
+    if (n == cap)
+    { FileRec * f = realloc(files,(cap = cap ? 2*cap : 256) * sizeof(FileRec));
+      if (f == NULL)
+      { free(path);
+        break;
+      }
+      files = f;
+    }
+    files[n].name = path;
+    files[n].size = st.st_size;
+    files[n].used = st.st_mtime;
+    total += st.st_size;
+    n++;
+  }
+  closedir(d);
+  if (total > c->maxBytes)
+  { long long goal = c->maxBytes / 100 * TRIMPERCENT;
+    qsort(files,n,sizeof(FileRec),byUse);
+    for (i = 0; i < n && total > goal; i++)
+      /* another process may have removed it already */
+      if (unlink(files[i].name) == 0 || errno == ENOENT)
+      { total -= files[i].size;
+        c->evictions++;
+      }
+  }
+  for (i = 0; i < n; i++) free(files[i].name);
+  free(files);
+  c->bytes = total;
+}
+
+/**************************************************/
+/***********   the cache               ************/
+/**************************************************/
+
+/* Function cacheOpen opens the cache in directory
+ * dir, creating it if needed, and keeps it under
+ * maxBytes by evicting the least recently used
+ * entries. Returns NULL if dir cannot be used
+ */
+Cache * cacheOpen( const char * dir, long long maxBytes )
+{ Cache * c;
+  struct stat st;
+  if (mkdir(dir,0777) < 0 && errno != EEXIST) return NULL;
+  if (stat(dir,&st) < 0 || !S_ISDIR(st.st_mode)) return NULL;
+  c = calloc(1,sizeof(Cache));
+  if (c == NULL || (c->dir = malloc(strlen(dir)+1)) == NULL)
+  { fprintf(stderr,"Out of memory for the cache\n");
+    exit(1);
+  }
+  strcpy(c->dir,dir);
+  c->maxBytes = maxBytes;
+  c->bytes = -1;
+  pthread_mutex_init(&c->lock,NULL);
+  return c;
+}
+
+/* Function cacheLookup looks the key up, filling e
+ * and marking the entry as recently used if it is
+ * there. Returns TRUE on a hit
+ */
+int cacheLookup( Cache * c, const CacheKey * key, CacheEntry * e )
+{ char * name = entryName(c,key);
+  int fd = open(name,O_RDONLY);
+  struct stat st;
+  unsigned long listLen, codeLen;
+  int status, head, ok = FALSE;
+  char * mem = NULL;
+  if (fd >= 0 && fstat(fd,&st) == 0 && st.st_size > 0
+      && (mem = malloc(st.st_size + 1)) != NULL)
+  { ssize_t got = 0, k;
+    while (got < st.st_size
+           && (k = read(fd,mem+got,st.st_size-got)) > 0)
+      got += k;
+    mem[got] = '\0';
+    /* the sizes in the header must account for the
+       whole file, or it is not a complete entry */
+    if (got == st.st_size
+        && sscanf(mem,ENTRYMAGIC " %d %lu %lu%n",
+                  &status,&listLen,&codeLen,&head) == 3
+        && mem[head++] == '\n'
+        && listLen <= (size_t) got - head
+        && codeLen == (size_t) got - head - listLen)
+    { e->status = status;
+      e->listing = mem + head;
+      e->listLen = listLen;
+      e->code = mem + head + listLen;
+      e->codeLen = codeLen;
+      e->mem = mem;
+      ok = TRUE;
+      /* the modification time records the last use */
+      futimens(fd,NULL);
+    }
+  }
+  if (fd >= 0) close(fd);
+  if (!ok) free(mem);
+  free(name);
+  pthread_mutex_lock(&c->lock);
+  if (ok) c->hits++;
+  else c->misses++;
+  pthread_mutex_unlock(&c->lock);
+  return ok;
+}
+
+/* writeAll writes n bytes to fd; returns FALSE on error */
+static int writeAll( int fd, const char * p, size_t n )
+{ while (n > 0)
+  { ssize_t k = write(fd,p,n);
+    if (k < 0 && errno == EINTR) continue;
+    if (k <= 0) return FALSE;
+    p += k;
+    n -= k;
+  }
+  return TRUE;
+}
+
+/* Procedure cacheStore adds a compilation to the
+ * cache. The entry is written to a temporary file
+ * and renamed into place, so readers in other
+ * processes never see part of it
+ */
+void cacheStore( Cache * c, const CacheKey * key, int status,
+                 const char * listing, size_t listLen,
+                 const char * code, size_t codeLen )
+{ char * name = entryName(c,key);
+  char * tmp = malloc(strlen(c->dir) + 48);
+  char head[64];
+  unsigned count;
+  int fd, ok;
+  if (tmp == NULL)
+  { fprintf(stderr,"Out of memory for the cache\n");
+    exit(1);
+  }
+  pthread_mutex_lock(&c->lock);
+  count = c->tmpCount++;
+  pthread_mutex_unlock(&c->lock);
+  /* unique among processes and among threads; not
+     named .cmc, so trim never counts it */
+  sprintf(tmp,"%s/tmp.%ld.%u",c->dir,(long) getpid(),count);
+  snprintf(head,sizeof(head),ENTRYMAGIC " %d %lu %lu\n",status,
+           (unsigned long) listLen,(unsigned long) codeLen);
+  fd = open(tmp,O_WRONLY|O_CREAT|O_TRUNC,0666);
+  ok = fd >= 0
+       && writeAll(fd,head,strlen(head))
+       && writeAll(fd,listing,listLen)
+       && writeAll(fd,code,codeLen);
+  if (fd >= 0 && close(fd) < 0) ok = FALSE;
+  if (ok && rename(tmp,name) == 0)
+  { pthread_mutex_lock(&c->lock);
+    c->stores++;
+    if (c->bytes < 0) trim(c);
+    else c->bytes += strlen(head) + listLen + codeLen;
+    if (c->bytes > c->maxBytes) trim(c);
+    pthread_mutex_unlock(&c->lock);
+  }
+  else if (fd >= 0) unlink(tmp);
+  free(tmp);
+  free(name);
+}
+
+/* Procedure cacheClose prints the hit and miss
+ * counts of this process to stats, unless it is
+ * NULL, and releases c
+ */
+void cacheClose( Cache * c, FILE * stats )
+{ if (stats != NULL)
+  { int lookups = c->hits + c->misses;
+    fprintf(stats,"cache %s: %d hits, %d misses (%.1f%% hit rate), "
+                  "%d stored, %d evicted\n",c->dir,c->hits,c->misses,
+            lookups ? 100.0 * c->hits / lookups : 0.0,
+            c->stores,c->evictions);
+  }
+  pthread_mutex_destroy(&c->lock);
+  free(c->dir);
+  free(c);
+}
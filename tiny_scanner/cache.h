@@ -0,0 +1,73 @@
+/****************************************************/
+/* File: cache.h                                    */
+/* Content-addressed on-disk cache of compilations  */
+/****************************************************/
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+/* COMPILER_VERSION is part of every cache key; change
+ * it whenever the listing or TM code the compiler
+ * produces for the same source could change
+ */
+#define COMPILER_VERSION "cm-1.5"
+
+/* a cache directory, shared by the threads of a
+ * process and by any number of processes
+ */
+typedef struct cache Cache;
+
+/* the key of a compilation: a 128-bit hash of the
+ * compiler version, the file name, the flags and
+ * the source bytes
+ */
+typedef struct
+   { unsigned long long hi, lo;
+   } CacheKey;
+
+/* a cached compilation, as found by cacheLookup */
+typedef struct
+   { int status;             /* what compileFile returned */
+     const char * listing;
+     size_t listLen;
+     const char * code;      /* the TM code, if codeLen > 0 */
+     size_t codeLen;
+     char * mem;             /* release with free */
+   } CacheEntry;
+
+/* Function cacheOpen opens the cache in directory
+ * dir, creating it if needed, and keeps it under
+ * maxBytes by evicting the least recently used
+ * entries. Returns NULL if dir cannot be used
+ */
+Cache * cacheOpen( const char * dir, long long maxBytes );
+
+/* Procedure cacheKey computes the key of compiling
+ * the len bytes of src, the file named pgm, with the
+ * output-affecting flags in flags
+ */
+void cacheKey( CacheKey * key, const char * pgm, unsigned flags,
+               const char * src, int len );
+
+/* Function cacheLookup looks the key up, filling e
+ * and marking the entry as recently used if it is
+ * there. Returns TRUE on a hit
+ */
+int cacheLookup( Cache * c, const CacheKey * key, CacheEntry * e );
+
+/* Procedure cacheStore adds a compilation to the
+ * cache. The entry is written to a temporary file
+ * and renamed into place, so readers in other
+ * processes never see part of it
+ */
+void cacheStore( Cache * c, const CacheKey * key, int status,
+                 const char * listing, size_t listLen,
+                 const char * code, size_t codeLen );
+
+/* Procedure cacheClose prints the hit and miss
+ * counts of this process to stats, unless it is
+ * NULL, and releases c
+ */
+void cacheClose( Cache * c, FILE * stats );
+
+#endif
@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: cgen.c                                     */
 /* The code generator implementation                */
-/* for the TINY compiler                            */
+/* for the C- compiler                              */
 /* (generates code for the TM machine)              */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
@@ -10,179 +10,480 @@
 #include "globals.h"
 #include "symtab.h"
 #include "code.h"
+#include "walk.h"
 #include "cgen.h"
 
-/* tmpOffset is the memory offset for temps
+/* The globals of a C- program are at their
+ * locations from gp. Each call of a function has a
+ * frame, which mp points to while it runs: the mp
+ * of the caller is at offset 0, the return address
+ * at 1, and the parameters, the locals and then the
+ * temporaries from -1 down, at the offsets analyze
+ * gave them. A call builds the frame of the callee
+ * below the temporaries of the caller, pushing the
+ * arguments as temporaries where the parameters go.
+ * Every name is found through the symbol analyze
+ * bound to its node (t->sym), so no name is looked
+ * up again
+ */
+
+/* cc->tmpOffset is the memory offset for temps
    It is decremented each time a temp is
    stored, and incremeted when loaded again
 */
-static int tmpOffset = 0;
-
-/* prototype for internal recursive code generator */
-static void cGen (TreeNode * tree);
-
-/* Procedure genStmt generates code at a statement node */
-static void genStmt( TreeNode * tree)
-{ TreeNode * p1, * p2, * p3;
-  int savedLoc1,savedLoc2,currentLoc;
-  int loc;
-  switch (tree->kind.stmt) {
-
-      case IfK :
-         if (TraceCode) emitComment("-> if") ;
-         p1 = tree->child[0] ;
-         p2 = tree->child[1] ;
-         p3 = tree->child[2] ;
-         /* generate code for test expression */
-         cGen(p1);
-         savedLoc1 = emitSkip(1) ;
-         emitComment("if: jump to else belongs here");
-         /* recurse on then part */
-         cGen(p2);
-         savedLoc2 = emitSkip(1) ;
-         emitComment("if: jump to end belongs here");
-         currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc1) ;
-         emitRM_Abs("JEQ",ac,currentLoc,"if: jmp to else");
-         emitRestore() ;
-         /* recurse on else part */
-         cGen(p3);
-         currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc2) ;
-         emitRM_Abs("LDA",pc,currentLoc,"jmp to end") ;
-         emitRestore() ;
-         if (TraceCode)  emitComment("<- if") ;
-         break; /* if_k */
-
-      case RepeatK:
-         if (TraceCode) emitComment("-> repeat") ;
-         p1 = tree->child[0] ;
-         p2 = tree->child[1] ;
-         savedLoc1 = emitSkip(0);
-         emitComment("repeat: jump after body comes back here");
-         /* generate code for body */
-         cGen(p1);
-         /* generate code for test */
-         cGen(p2);
-         emitRM_Abs("JEQ",ac,savedLoc1,"repeat: jmp back to body");
-         if (TraceCode)  emitComment("<- repeat") ;
-         break; /* repeat */
-
-      case AssignK:
-         if (TraceCode) emitComment("-> assign") ;
-         /* generate code for rhs */
-         cGen(tree->child[0]);
-         /* now store value */
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"assign: store value");
-         if (TraceCode)  emitComment("<- assign") ;
-         break; /* assign_k */
-
-      case ReadK:
-         emitRO("IN",ac,0,0,"read integer value");
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"read: store value");
-         break;
-      case WriteK:
-         /* generate code for expression to write */
-         cGen(tree->child[0]);
-         /* now output it */
-         emitRO("OUT",ac,0,0,"write ac");
-         break;
-      default:
-         break;
-    }
-} /* genStmt */
-
-/* Procedure genExp generates code at an expression node */
-static void genExp( TreeNode * tree)
-{ int loc;
-  TreeNode * p1, * p2;
-  switch (tree->kind.exp) {
-
-    case ConstK :
-      if (TraceCode) emitComment("-> Const") ;
-      /* gen code to load integer constant using LDC */
-      emitRM("LDC",ac,tree->attr.val,0,"load const");
-      if (TraceCode)  emitComment("<- Const") ;
-      break; /* ConstK */
-    
-    case IdK :
-      if (TraceCode) emitComment("-> Id") ;
-      loc = st_lookup(tree->attr.name);
-      emitRM("LD",ac,loc,gp,"load id value");
-      if (TraceCode)  emitComment("<- Id") ;
-      break; /* IdK */
 
+/* An expression is evaluated into registers, the
+ * way Sethi and Ullman number them: its value goes
+ * to a register r and it may use r up to NREGS-1.
+ * labelNode numbers each node with the registers
+ * it needs (t->need); an operator evaluates its
+ * needier operand first, if neither calls nor
+ * assigns, so the other one needs one register
+ * less, and only when the second operand needs
+ * more registers than are left does the first one
+ * go to a temp. The callee of a call may use every
+ * register, so a call counts as needing them all:
+ * it is always evaluated into ac with none in use,
+ * its result where the callee leaves it, and its
+ * arguments are evaluated into ac in turn
+ */
+
+/* the registers values are kept in: all but gp, mp
+   and pc */
+#define NREGS gp
+
+/* flags of an operator or assignment, in local[1] */
+#define SWAPPED 1 /* the right operand is evaluated first */
+#define SPILLED 2 /* the first operand went to a temp */
+
+/* The code of a node is generated around the code
+ * of its children as walkTree (walk.h) walks them:
+ * genPre runs before the first child, genIn before
+ * each one and genPost after the last. Code
+ * locations to be backpatched are kept in the
+ * frame of the node, in local[]; a call keeps there
+ * the offset the frame of the callee starts at
+ */
+
+/* base returns the register s is addressed from */
+static int base( Symbol * s )
+{ return s->scope == 0 ? gp : mp;
+}
+
+/* predeclared tells whether the function s is
+   input or output, which have no body and are
+   compiled into IN and OUT */
+static int predeclared( Symbol * s )
+{ return s->decl->child[2] == NULL;
+}
+
+/* lvalue tells whether t is the variable an
+   assignment assigns to */
+static int lvalue( Compiler * cc, TreeNode * t )
+{ WalkFrame * up = walkFrame(cc,1);
+  return up != NULL && up->t->nodekind == ExpK
+         && up->t->kind.exp == AssignK && up->t->child[0] == t;
+}
+
+/* argument tells whether the node being generated is
+   an argument of a call that passes it in the frame
+   of the callee */
+static int argument( Compiler * cc )
+{ WalkFrame * up = walkFrame(cc,1);
+  return up != NULL && up->t->nodekind == ExpK
+         && up->t->kind.exp == CallK && !predeclared(up->t->sym);
+}
+
+/* emitAddress loads the address of the array s into
+   register r */
+static void emitAddress( Compiler * cc, int r, Symbol * s )
+{ if (s->kind == ArrParamK)
+    emitRM(cc,"LD",r,s->offset,mp,"load array address");
+  else
+    emitRM(cc,"LDA",r,s->offset,base(s),"load array address");
+}
+
+/* emitReturn returns from the current function with
+   the value in ac */
+static void emitReturn( Compiler * cc )
+{ emitRM(cc,"LD",ac1,1,mp,"return: load return address");
+  emitRM(cc,"LD",mp,0,mp,"return: restore mp");
+  emitRM(cc,"LDA",pc,0,ac1,"return: jump back");
+}
+
+/* max returns the greater of a and b */
+static int max( int a, int b )
+{ return a > b ? a : b;
+}
+
+/* labelNode numbers an expression with the registers
+   it needs, its operands numbered already */
+static void labelNode( Compiler * cc, TreeNode * t )
+{ TreeNode * l = t->child[0], * r = t->child[1];
+  (void) cc; /* a walk hook; the numbers are in t */
+  if (t->nodekind != ExpK) return;
+  t->need = 1;
+  t->pure = TRUE;
+  switch (t->kind.exp) {
+    case ArrIdK :
+      /* the index, then the address of the array */
+      t->need = max(l->need,2);
+      t->pure = l->pure;
+      break;
     case OpK :
-         if (TraceCode) emitComment("-> Op") ;
-         p1 = tree->child[0];
-         p2 = tree->child[1];
-         /* gen code for ac = left arg */
-         cGen(p1);
-         /* gen code to push left operand */
-         emitRM("ST",ac,tmpOffset--,mp,"op: push left");
-         /* gen code for ac = right operand */
-         cGen(p2);
-         /* now load left operand */
-         emitRM("LD",ac1,++tmpOffset,mp,"op: load left");
-         switch (tree->attr.op) {
-            case PLUS :
-               emitRO("ADD",ac,ac1,ac,"op +");
-               break;
-            case MINUS :
-               emitRO("SUB",ac,ac1,ac,"op -");
-               break;
-            case TIMES :
-               emitRO("MUL",ac,ac1,ac,"op *");
-               break;
-            case OVER :
-               emitRO("DIV",ac,ac1,ac,"op /");
-               break;
-            case LT :
-               emitRO("SUB",ac,ac1,ac,"op <") ;
-               emitRM("JLT",ac,2,pc,"br if true") ;
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            case EQ :
-               emitRO("SUB",ac,ac1,ac,"op ==") ;
-               emitRM("JEQ",ac,2,pc,"br if true");
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            default:
-               emitComment("BUG: Unknown operator");
-               break;
-         } /* case op */
-         if (TraceCode)  emitComment("<- Op") ;
-         break; /* OpK */
+      t->pure = l->pure && r->pure;
+      if (!t->pure)
+        t->need = max(l->need,r->need + 1);
+      else if (l->need == r->need)
+        t->need = l->need + 1;
+      else
+        t->need = max(l->need,r->need);
+      break;
+    case AssignK :
+      t->pure = FALSE;
+      if (l->kind.exp == IdK) t->need = r->need;
+      else t->need = max(l->need,r->need + 1);
+      break;
+    case CallK :
+      t->pure = FALSE;
+      if (!predeclared(t->sym)) t->need = NREGS;
+      else if (l != NULL) t->need = l->need;
+      break;
+    default:
+      break;
+  }
+}
+
+/* target returns the register the value of the
+   node being generated goes to, which its parent
+   keeps in n */
+static int target( Compiler * cc )
+{ WalkFrame * up = walkFrame(cc,1);
+  return up != NULL ? up->n : 0;
+}
+
+/* second returns the register the second operand of
+   the operator or assignment at the current frame
+   goes to, spilling the first one if it needs more
+   registers than are left above it */
+static int second( Compiler * cc, TreeNode * t, char * comment )
+{ int * local = walkFrame(cc,0)->local;
+  int r = local[0];
+  if (t->need <= NREGS - r - 1) return r + 1;
+  emitRM(cc,"ST",r,cc->tmpOffset--,mp,comment);
+  local[1] |= SPILLED;
+  return r;
+}
 
+/* swap exchanges the operands of t */
+static void swap( TreeNode * t )
+{ TreeNode * c = t->child[0];
+  t->child[0] = t->child[1];
+  t->child[1] = c;
+}
+
+/* Procedure genPre generates code at a node before
+ * its children
+ */
+static void genPre( Compiler * cc, TreeNode * tree)
+{ WalkFrame * fr = walkFrame(cc,0);
+  int * local = fr->local;
+  Symbol * s = tree->sym;
+  int r = 0;
+  /* the expressions of a statement start at ac; an
+     expression keeps its register in local[0] */
+  if (tree->nodekind == ExpK) r = local[0] = target(cc);
+  fr->n = r;
+  switch (tree->nodekind) {
+    case DeclK:
+      if (tree->kind.decl == FuncK)
+      { if (cc->TraceCode) emitComment(cc,"-> function") ;
+        /* a function is at the code location of its
+           symbol from here on */
+        s->offset = emitSkip(cc,0);
+        cc->function = s;
+        cc->tmpOffset = -1;
+        emitRM(cc,"ST",ac,1,mp,"function: store return address");
+      }
+      else
+      { /* the temporaries go below the locals */
+        if (s->scope > 0 && s->offset <= cc->tmpOffset)
+          cc->tmpOffset = s->offset - 1;
+        walkSkip(cc);
+      }
+      break;
+
+    case StmtK:
+      switch (tree->kind.stmt) {
+        case IfK :
+          if (cc->TraceCode) emitComment(cc,"-> if") ;
+          break;
+        case LoopK :
+          if (cc->TraceCode) emitComment(cc,"-> while") ;
+          local[0] = emitSkip(cc,0);
+          emitComment(cc,"while: jump after body comes back here");
+          break;
+        case RetK :
+          if (cc->TraceCode) emitComment(cc,"-> return") ;
+          break;
+        default:
+          break;
+      }
+      break;
+
+    case ExpK:
+      switch (tree->kind.exp) {
+        case ConstK :
+          if (cc->TraceCode) emitComment(cc,"-> Const") ;
+          /* gen code to load integer constant using LDC */
+          emitRM(cc,"LDC",r,tree->attr.val,0,"load const");
+          if (cc->TraceCode)  emitComment(cc,"<- Const") ;
+          break; /* ConstK */
+
+        case IdK :
+          /* the variable assigned to is stored by the
+             assignment */
+          if (lvalue(cc,tree)) break;
+          if (cc->TraceCode) emitComment(cc,"-> Id") ;
+          if (s->kind == ArrVarK || s->kind == ArrParamK)
+            emitAddress(cc,r,s);
+          else
+            emitRM(cc,"LD",r,s->offset,base(s),"load id value");
+          if (cc->TraceCode)  emitComment(cc,"<- Id") ;
+          break; /* IdK */
+
+        case CallK :
+          if (cc->TraceCode) emitComment(cc,"-> call") ;
+          if (!predeclared(s))
+          { /* the mp and return address slots of the
+               callee's frame */
+            local[1] = cc->tmpOffset;
+            cc->tmpOffset -= 2;
+          }
+          break;
+
+        case OpK :
+          local[1] = 0;
+          /* the needier operand first, unless
+             evaluating them may have effects */
+          if (tree->child[0]->pure && tree->child[1]->pure
+              && tree->child[1]->need > tree->child[0]->need)
+          { swap(tree);
+            local[1] = SWAPPED;
+          }
+          break;
+
+        case AssignK :
+          local[1] = 0;
+          break;
+
+        default:
+          break;
+      }
+      break;
+
+    /* no code is generated for types */
     default:
+      walkSkip(cc);
       break;
   }
-} /* genExp */
+} /* genPre */
 
-/* Procedure cGen recursively generates code by
- * tree traversal
+/* Procedure genIn generates code at a node before
+ * its child list i
  */
-static void cGen( TreeNode * tree)
-{ if (tree != NULL)
-  { switch (tree->nodekind) {
-      case StmtK:
-        genStmt(tree);
+static void genIn( Compiler * cc, TreeNode * tree, int i)
+{ int * local = walkFrame(cc,0)->local;
+  int currentLoc;
+  if (tree->nodekind == StmtK && tree->kind.stmt == IfK)
+  { if (i == 1)
+    { /* the test is done; the then part follows */
+      local[0] = emitSkip(cc,1) ;
+      emitComment(cc,"if: jump to else belongs here");
+    }
+    else if (i == 2)
+    { /* the then part is done; the else part follows */
+      local[1] = emitSkip(cc,1) ;
+      emitComment(cc,"if: jump to end belongs here");
+      currentLoc = emitSkip(cc,0) ;
+      emitBackup(cc,local[0]) ;
+      emitRM_Abs(cc,"JEQ",ac,currentLoc,"if: jmp to else");
+      emitRestore(cc) ;
+    }
+  }
+  else if (tree->nodekind == StmtK && tree->kind.stmt == LoopK && i == 1)
+  { /* the test is done; the body follows */
+    local[1] = emitSkip(cc,1) ;
+    emitComment(cc,"while: jump to end belongs here");
+  }
+  else if (tree->nodekind == ExpK && tree->kind.exp == OpK && i == 1)
+    walkFrame(cc,0)->n = second(cc,tree->child[1],"op: spill operand");
+  else if (tree->nodekind == ExpK && tree->kind.exp == AssignK && i == 1
+           && tree->child[0]->kind.exp == ArrIdK)
+    walkFrame(cc,0)->n = second(cc,tree->child[1],"assign: spill address");
+} /* genIn */
+
+/* Procedure genOp generates the code of the operator
+ * of tree into register r, the left operand in
+ * register left and the right one in right
+ */
+static void genOp( Compiler * cc, TreeNode * tree, int r, int left, int right)
+{ char * jump = NULL;
+  switch (tree->attr.op) {
+     case PLUS :
+        emitRO(cc,"ADD",r,left,right,"op +");
         break;
-      case ExpK:
-        genExp(tree);
+     case MINUS :
+        emitRO(cc,"SUB",r,left,right,"op -");
         break;
-      default:
+     case TIMES :
+        emitRO(cc,"MUL",r,left,right,"op *");
         break;
-    }
-    cGen(tree->sibling);
+     case OVER :
+        emitRO(cc,"DIV",r,left,right,"op /");
+        break;
+     case LT :  jump = "JLT"; break;
+     case LTE : jump = "JLE"; break;
+     case GT :  jump = "JGT"; break;
+     case GTE : jump = "JGE"; break;
+     case EQ :  jump = "JEQ"; break;
+     case NEQ : jump = "JNE"; break;
+     default:
+        emitComment(cc,"BUG: Unknown operator");
+        break;
+  } /* case op */
+  if (jump != NULL)
+  { emitRO(cc,"SUB",r,left,right,"op compare") ;
+    emitRM(cc,jump,r,2,pc,"br if true") ;
+    emitRM(cc,"LDC",r,0,r,"false case") ;
+    emitRM(cc,"LDA",pc,1,pc,"unconditional jmp") ;
+    emitRM(cc,"LDC",r,1,r,"true case") ;
   }
-}
+} /* genOp */
+
+/* Procedure genPost generates code at a node after
+ * its children
+ */
+static void genPost( Compiler * cc, TreeNode * tree)
+{ int * local = walkFrame(cc,0)->local;
+  Symbol * s = tree->sym;
+  int currentLoc, r = local[0], first, other;
+  switch (tree->nodekind) {
+    case DeclK:
+      if (tree->kind.decl == FuncK)
+      { /* falling off the end returns */
+        emitReturn(cc);
+        cc->function = NULL;
+        if (cc->TraceCode)  emitComment(cc,"<- function") ;
+      }
+      break;
+
+    case StmtK:
+      switch (tree->kind.stmt) {
+        case IfK :
+          currentLoc = emitSkip(cc,0) ;
+          emitBackup(cc,local[1]) ;
+          emitRM_Abs(cc,"LDA",pc,currentLoc,"jmp to end") ;
+          emitRestore(cc) ;
+          if (cc->TraceCode)  emitComment(cc,"<- if") ;
+          break; /* if_k */
+
+        case LoopK :
+          emitRM_Abs(cc,"LDA",pc,local[0],"while: jmp back to test");
+          currentLoc = emitSkip(cc,0) ;
+          emitBackup(cc,local[1]) ;
+          emitRM_Abs(cc,"JEQ",ac,currentLoc,"while: jmp to end");
+          emitRestore(cc) ;
+          if (cc->TraceCode)  emitComment(cc,"<- while") ;
+          break; /* while */
+
+        case RetK :
+          emitReturn(cc);
+          if (cc->TraceCode)  emitComment(cc,"<- return") ;
+          break;
+
+        default:
+          break;
+      }
+      break;
+
+    case ExpK:
+      switch (tree->kind.exp) {
+        case ArrIdK :
+          /* the index is in r; an element assigned to
+             is left with its address there */
+          emitAddress(cc,r+1,s);
+          emitRO(cc,"ADD",r,r+1,r,"element address");
+          if (!lvalue(cc,tree))
+            emitRM(cc,"LD",r,0,r,"load element value");
+          break;
+
+        case AssignK :
+          /* now store value */
+          if (tree->child[0]->kind.exp == IdK)
+          { Symbol * v = tree->child[0]->sym;
+            emitRM(cc,"ST",r,v->offset,base(v),"assign: store value");
+          }
+          else if (local[1] & SPILLED)
+          { emitRM(cc,"LD",r+1,++cc->tmpOffset,mp,"assign: load address");
+            emitRM(cc,"ST",r,0,r+1,"assign: store value");
+          }
+          else
+          { emitRM(cc,"ST",r+1,0,r,"assign: store value");
+            /* the value of an assignment in an
+               expression is used */
+            if (walkFrame(cc,1)->t->nodekind == ExpK)
+              emitRM(cc,"LDA",r,0,r+1,"assign: move value");
+          }
+          if (cc->TraceCode)  emitComment(cc,"<- assign") ;
+          break; /* assign_k */
+
+        case OpK :
+          /* the first operand is in r, or in a temp
+             and the second one in r */
+          first = r;
+          other = r + 1;
+          if (local[1] & SPILLED)
+          { first = r + 1;
+            other = r;
+            emitRM(cc,"LD",first,++cc->tmpOffset,mp,"op: load operand");
+          }
+          if (local[1] & SWAPPED)
+          { genOp(cc,tree,r,other,first);
+            swap(tree);
+          }
+          else
+            genOp(cc,tree,r,first,other);
+          if (cc->TraceCode)  emitComment(cc,"<- Op") ;
+          break;
+
+        case CallK :
+          if (!predeclared(s))
+          { emitRM(cc,"ST",mp,local[1]-1,mp,"call: store mp");
+            emitRM(cc,"LDA",mp,local[1]-1,mp,"call: push frame");
+            emitRM(cc,"LDA",ac,1,pc,"call: return address");
+            emitRM_Abs(cc,"LDA",pc,s->offset,"call: jump to function");
+            cc->tmpOffset = local[1];
+          }
+          else if (tree->child[0] == NULL)
+            emitRO(cc,"IN",r,0,0,"read integer value");
+          else
+            emitRO(cc,"OUT",r,0,0,"write integer value");
+          if (cc->TraceCode)  emitComment(cc,"<- call") ;
+          break;
+
+        default:
+          break;
+      }
+      /* an argument goes where its parameter is */
+      if (argument(cc))
+        emitRM(cc,"ST",r,cc->tmpOffset--,mp,"call: push argument");
+      break;
+
+    default:
+      break;
+  }
+} /* genPost */
 
 /**********************************************/
 /* the primary function of the code generator */
@@ -193,20 +494,37 @@ static void cGen( TreeNode * tree)
  * of the code file, and is used to print the
  * file name as a comment in the code file
  */
-void codeGen(TreeNode * syntaxTree, char * codefile)
+void codeGen(Compiler * cc, TreeNode * syntaxTree, char * codefile)
 {  char * s = malloc(strlen(codefile)+7);
+   TreeNode * t, * main = NULL;
+   int callMain;
    strcpy(s,"File: ");
    strcat(s,codefile);
-   emitComment("TINY Compilation to TM Code");
-   emitComment(s);
+   emitComment(cc,"C- Compilation to TM Code");
+   emitComment(cc,s);
+   free(s);
    /* generate standard prelude */
-   emitComment("Standard prelude:");
-   emitRM("LD",mp,0,ac,"load maxaddress from location 0");
-   emitRM("ST",ac,0,ac,"clear location 0");
-   emitComment("End of standard prelude.");
-   /* generate code for TINY program */
-   cGen(syntaxTree);
-   /* finish */
-   emitComment("End of execution.");
-   emitRO("HALT",0,0,0,"");
+   emitComment(cc,"Standard prelude:");
+   emitRM(cc,"LD",mp,0,ac,"load maxaddress from location 0");
+   emitRM(cc,"ST",ac,0,ac,"clear location 0");
+   /* main is called as from a frame with nothing in it */
+   emitRM(cc,"ST",mp,-1,mp,"call main: store mp");
+   emitRM(cc,"LDA",mp,-1,mp,"call main: push frame");
+   emitRM(cc,"LDA",ac,1,pc,"call main: return address");
+   callMain = emitSkip(cc,1);
+   emitRO(cc,"HALT",0,0,0,"");
+   emitComment(cc,"End of standard prelude.");
+   /* generate code for C- program, its expressions
+      numbered first */
+   walkTree(cc,syntaxTree,NULL,NULL,labelNode);
+   walkTree(cc,syntaxTree,genPre,genIn,genPost);
+   /* main is the last declaration */
+   for (t = syntaxTree; t != NULL; t = t->sibling) main = t;
+   emitBackup(cc,callMain);
+   if (main != NULL && main->kind.decl == FuncK)
+     emitRM_Abs(cc,"LDA",pc,main->sym->offset,"call main: jump");
+   else
+     emitRO(cc,"HALT",0,0,0,"no main");
+   emitRestore(cc);
+   emitComment(cc,"End of execution.");
 }
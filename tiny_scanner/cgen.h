@@ -1,6 +1,6 @@
 /****************************************************/
 /* File: cgen.h                                     */
-/* The code generator interface to the TINY compiler*/
+/* The code generator interface to the C- compiler  */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,12 +8,19 @@
 #ifndef _CGEN_H_
 #define _CGEN_H_
 
+/* CODEGEN names the way codeGen generates code, and
+ * is part of the cache key: 1 pushed every left
+ * operand to a temp, 2 evaluates expressions into
+ * registers
+ */
+#define CODEGEN 2
+
 /* Procedure codeGen generates code to a code
  * file by traversal of the syntax tree. The
  * second parameter (codefile) is the file name
  * of the code file, and is used to print the
  * file name as a comment in the code file
  */
-void codeGen(TreeNode * syntaxTree, char * codefile);
+void codeGen(Compiler * cc, TreeNode * syntaxTree, char * codefile);
 
 #endif
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,8 +31,9 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 #ifndef YY_YY_CM_TAB_H_INCLUDED
 # define YY_YY_CM_TAB_H_INCLUDED
@@ -43,56 +44,83 @@
 #if YYDEBUG
 extern int yydebug;
 #endif
+/* "%code requires" blocks.  */
+#line 34 "yacc/cm.y"
 
-/* Token type.  */
+struct compiler;
+struct treeNode;
+
+/* a sibling chain under construction */
+typedef struct nodeList
+   { struct treeNode * head;
+     struct treeNode * tail;   /* last node of the chain */
+   } NodeList;
+
+#line 60 "cm.tab.h"
+
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    IF = 258,
-    ELSE = 259,
-    RETURN = 260,
-    WHILE = 261,
-    INT = 262,
-    VOID = 263,
-    ID = 264,
-    NUM = 265,
-    ASSIGN = 266,
-    EQ = 267,
-    NEQ = 268,
-    LT = 269,
-    LTE = 270,
-    GT = 271,
-    GTE = 272,
-    PLUS = 273,
-    MINUS = 274,
-    TIMES = 275,
-    OVER = 276,
-    LPAREN = 277,
-    LSQUAREB = 278,
-    LCURLY = 279,
-    RPAREN = 280,
-    RSQUAREB = 281,
-    RCURLY = 282,
-    SEMICOLON = 283,
-    COMMA = 284,
-    ERROR = 285,
-    C_COMMENT = 286,
-    COMMENT_ERROR = 287,
-    ENDFILE = 288
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    IF = 258,                      /* IF  */
+    ELSE = 259,                    /* ELSE  */
+    RETURN = 260,                  /* RETURN  */
+    WHILE = 261,                   /* WHILE  */
+    INT = 262,                     /* INT  */
+    VOID = 263,                    /* VOID  */
+    ID = 264,                      /* ID  */
+    NUM = 265,                     /* NUM  */
+    ASSIGN = 266,                  /* ASSIGN  */
+    EQ = 267,                      /* EQ  */
+    NEQ = 268,                     /* NEQ  */
+    LT = 269,                      /* LT  */
+    LTE = 270,                     /* LTE  */
+    GT = 271,                      /* GT  */
+    GTE = 272,                     /* GTE  */
+    PLUS = 273,                    /* PLUS  */
+    MINUS = 274,                   /* MINUS  */
+    TIMES = 275,                   /* TIMES  */
+    OVER = 276,                    /* OVER  */
+    LPAREN = 277,                  /* LPAREN  */
+    LSQUAREB = 278,                /* LSQUAREB  */
+    LCURLY = 279,                  /* LCURLY  */
+    RPAREN = 280,                  /* RPAREN  */
+    RSQUAREB = 281,                /* RSQUAREB  */
+    RCURLY = 282,                  /* RCURLY  */
+    SEMICOLON = 283,               /* SEMICOLON  */
+    COMMA = 284,                   /* COMMA  */
+    ERROR = 285,                   /* ERROR  */
+    C_COMMENT = 286,               /* C_COMMENT  */
+    COMMENT_ERROR = 287,           /* COMMENT_ERROR  */
+    ENDFILE = 288                  /* ENDFILE  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef int YYSTYPE;
+union YYSTYPE
+{
+#line 32 "yacc/cm.y"
+ struct treeNode * node; NodeList list; int tok; 
+
+#line 113 "cm.tab.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
 
-extern YYSTYPE yylval;
 
-int yyparse (void);
+
+int yyparse (struct compiler * cc);
+
 
 #endif /* !YY_YY_CM_TAB_H_INCLUDED  */
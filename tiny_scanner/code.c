@@ -9,19 +9,46 @@
 #include "globals.h"
 #include "code.h"
 
-/* TM location number for current instruction emission */
-static int emitLoc = 0 ;
-
-/* Highest TM location emitted so far
-   For use in conjunction with emitSkip,
-   emitBackup, and emitRestore */
-static int highEmitLoc = 0;
+/* cc->emitLoc is the TM location number for
+   current instruction emission, and cc->highEmitLoc
+   the highest TM location emitted so far, for use
+   in conjunction with emitSkip, emitBackup, and
+   emitRestore */
 
 /* Procedure emitComment prints a comment line 
  * with comment c in the code file
  */
-void emitComment( char * c )
-{ if (TraceCode) fprintf(code,"* %s\n",c);}
+void emitComment( Compiler * cc, char * c )
+{ if (cc->TraceCode)
+  { outStr(cc->code,"* ");
+    outStr(cc->code,c);
+    outChar(cc->code,'\n');
+  }
+}
+
+/* emitLine prints the instruction op r,a,b at loc,
+ * as r,a(b) for a register-to-memory one (rm TRUE),
+ * followed by comment c if cc->TraceCode is TRUE
+ */
+static void emitLine( Compiler * cc, int loc, char * op,
+                      int r, int a, int b, int rm, char * c )
+{ Out * o = cc->code;
+  outInt(o,loc,3);
+  outStr(o,":  ");
+  outStrField(o,op,5);
+  outStr(o,"  ");
+  outInt(o,r,0);
+  outChar(o,',');
+  outInt(o,a,0);
+  outChar(o,rm ? '(' : ',');
+  outInt(o,b,0);
+  outStr(o,rm ? ") " : " ");
+  if (cc->TraceCode)
+  { outChar(o,'\t');
+    outStr(o,c);
+  }
+  outChar(o,'\n');
+}
 
 /* Procedure emitRO emits a register-only
  * TM instruction
@@ -29,13 +56,11 @@ void emitComment( char * c )
  * r = target register
  * s = 1st source register
  * t = 2nd source register
- * c = a comment to be printed if TraceCode is TRUE
+ * c = a comment to be printed if cc->TraceCode is TRUE
  */
-void emitRO( char *op, int r, int s, int t, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d,%d ",emitLoc++,op,r,s,t);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+void emitRO( Compiler * cc, char *op, int r, int s, int t, char *c)
+{ emitLine(cc,cc->emitLoc++,op,r,s,t,FALSE,c);
+  if (cc->highEmitLoc < cc->emitLoc) cc->highEmitLoc = cc->emitLoc ;
 } /* emitRO */
 
 /* Procedure emitRM emits a register-to-memory
@@ -44,40 +69,38 @@ void emitRO( char *op, int r, int s, int t, char *c)
  * r = target register
  * d = the offset
  * s = the base register
- * c = a comment to be printed if TraceCode is TRUE
+ * c = a comment to be printed if cc->TraceCode is TRUE
  */
-void emitRM( char * op, int r, int d, int s, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",emitLoc++,op,r,d,s);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
+void emitRM( Compiler * cc, char * op, int r, int d, int s, char *c)
+{ emitLine(cc,cc->emitLoc++,op,r,d,s,TRUE,c);
+  if (cc->highEmitLoc < cc->emitLoc)  cc->highEmitLoc = cc->emitLoc ;
 } /* emitRM */
 
 /* Function emitSkip skips "howMany" code
  * locations for later backpatch. It also
  * returns the current code position
  */
-int emitSkip( int howMany)
-{  int i = emitLoc;
-   emitLoc += howMany ;
-   if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
+int emitSkip( Compiler * cc, int howMany)
+{  int i = cc->emitLoc;
+   cc->emitLoc += howMany ;
+   if (cc->highEmitLoc < cc->emitLoc)  cc->highEmitLoc = cc->emitLoc ;
    return i;
 } /* emitSkip */
 
 /* Procedure emitBackup backs up to 
  * loc = a previously skipped location
  */
-void emitBackup( int loc)
-{ if (loc > highEmitLoc) emitComment("BUG in emitBackup");
-  emitLoc = loc ;
+void emitBackup( Compiler * cc, int loc)
+{ if (loc > cc->highEmitLoc) emitComment(cc,"BUG in emitBackup");
+  cc->emitLoc = loc ;
 } /* emitBackup */
 
 /* Procedure emitRestore restores the current 
  * code position to the highest previously
  * unemitted position
  */
-void emitRestore(void)
-{ emitLoc = highEmitLoc;}
+void emitRestore( Compiler * cc )
+{ cc->emitLoc = cc->highEmitLoc;}
 
 /* Procedure emitRM_Abs converts an absolute reference 
  * to a pc-relative reference when emitting a
@@ -85,13 +108,10 @@ void emitRestore(void)
  * op = the opcode
  * r = target register
  * a = the absolute location in memory
- * c = a comment to be printed if TraceCode is TRUE
+ * c = a comment to be printed if cc->TraceCode is TRUE
  */
-void emitRM_Abs( char *op, int r, int a, char * c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",
-               emitLoc,op,r,a-(emitLoc+1),pc);
-  ++emitLoc ;
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+void emitRM_Abs( Compiler * cc, char *op, int r, int a, char * c)
+{ emitLine(cc,cc->emitLoc,op,r,a-(cc->emitLoc+1),pc,TRUE,c);
+  ++cc->emitLoc ;
+  if (cc->highEmitLoc < cc->emitLoc) cc->highEmitLoc = cc->emitLoc ;
 } /* emitRM_Abs */
@@ -0,0 +1,88 @@
+/****************************************************/
+/* File: compiler.c                                 */
+/* Setting up and tearing down the compilation      */
+/* context of the C- compiler                       */
+/****************************************************/
+
+#include "globals.h"
+#include "compiler.h"
+#include "scan.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "intern.h"
+#include "arena.h"
+#include "flat.h"
+#include "walk.h"
+#include "tokbuf.h"
+#include "symtab.h"
+
+/* Procedure compilerInit prepares cc for compiling
+ * pgm, with the default flags and listing on stdout
+ */
+void compilerInit( Compiler * cc, const char * pgm )
+{ memset(cc,0,sizeof(Compiler));
+  cc->pgm = pgm;
+  outOpen(&cc->out,stdout);
+  cc->listing = &cc->out;
+  cc->EchoSource = EchoSource;
+  cc->TraceScan = TraceScan;
+  cc->TraceParse = TraceParse;
+  cc->TraceAnalyze = TraceAnalyze;
+  cc->TraceCode = TraceCode;
+  cc->TraceMemory = TraceMemory;
+  cc->MapSource = MapSource;
+  cc->PreTokenize = PreTokenize;
+  cc->LexThreads = LexThreads;
+  cc->AnalyzeThreads = AnalyzeThreads;
+  cc->RDParse = RDParse;
+  cc->FlatAST = FlatAST;
+  cc->DumpAST = DumpAST;
+  cc->curTok = -1;
+}
+
+/* Procedure compilerReset prepares cc, which has
+ * compiled something before, for compiling pgm. The
+ * token buffer, intern table, arena, flat tree, walk
+ * stack and line tables keep their memory; everything
+ * else starts over as in compilerInit. The caller
+ * closes the files and releases a source buffer it
+ * supplied itself
+ */
+void compilerReset( Compiler * cc, const char * pgm )
+{ Compiler keep;
+  outClose(&cc->out);
+  scanFree(cc);
+  st_free(cc);
+  unmapSource(cc);
+  internReset(cc);
+  arenaReset(cc);
+  srcFilesReset(cc);
+  keep = *cc;
+  compilerInit(cc,pgm);
+  cc->files = keep.files;
+  cc->atoms = keep.atoms;
+  cc->arena = keep.arena;
+  cc->flat = keep.flat;
+  cc->walk = keep.walk;
+  cc->tokKind = keep.tokKind;
+  cc->tokOff = keep.tokOff;
+  cc->tokLen = keep.tokLen;
+  cc->tokCap = keep.tokCap;
+}
+
+/* Procedure compilerFree releases everything cc
+ * holds except its files, which the caller opened,
+ * flushing the listing on stdout
+ */
+void compilerFree( Compiler * cc )
+{ scanFree(cc);
+  tokFree(cc);
+  st_free(cc);
+  internFree(cc);
+  arenaFree(cc);
+  flatFree(cc);
+  walkFree(cc);
+  srcFilesFree(cc);
+  unmapSource(cc);
+  outClose(&cc->out);
+}
@@ -0,0 +1,31 @@
+/****************************************************/
+/* File: compiler.h                                 */
+/* Setting up and tearing down the compilation      */
+/* context of the C- compiler                       */
+/****************************************************/
+
+#ifndef _COMPILER_H_
+#define _COMPILER_H_
+
+/* Procedure compilerInit prepares cc for compiling
+ * pgm, with the default flags and listing on stdout
+ */
+void compilerInit( Compiler * cc, const char * pgm );
+
+/* Procedure compilerReset prepares cc, which has
+ * compiled something before, for compiling pgm. The
+ * token buffer, intern table, arena, flat tree, walk
+ * stack and line tables keep their memory; everything
+ * else starts over as in compilerInit. The caller
+ * closes the files and releases a source buffer it
+ * supplied itself
+ */
+void compilerReset( Compiler * cc, const char * pgm );
+
+/* Procedure compilerFree releases everything cc
+ * holds except its files, which the caller opened,
+ * flushing the listing on stdout
+ */
+void compilerFree( Compiler * cc );
+
+#endif
@@ -0,0 +1,103 @@
+/****************************************************/
+/* File: dfa.c                                      */
+/* Table-driven DFA scanner core for C-             */
+/* The tables in scantab.h are generated at build   */
+/* time by scangen                                  */
+/****************************************************/
+
+#include "globals.h"
+#include "dfa.h"
+#include "skip.h"
+#include "scantab.h"
+
+/* Procedure scanInit starts a scan of buf[pos..end) */
+void scanInit( ScanState * s, const char * buf, int pos, int end )
+{ s->buf = buf;
+  s->pos = pos;
+  s->end = end;
+  s->tokStart = pos;
+  s->inComment = FALSE;
+}
+
+/* keywordLookup maps an identifier to its reserved
+ * word token through the perfect hash in scantab.h
+ */
+static TokenType keywordLookup( const char * s, int len )
+{ int h;
+  if (len < 2 || len > 6) return ID;
+  h = KW_HASH(s,len);
+  if (kwTable[h].len == len && memcmp(kwTable[h].str,s,len) == 0)
+    return kwTable[h].tok;
+  return ID;
+}
+
+/****************************************/
+/* the primary function of the scanner  */
+/****************************************/
+/* Function scanToken returns the next token of the
+ * scan, skipping blanks and comments; ENDFILE at the
+ * end of the text
+ */
+TokenType scanToken( ScanState * s )
+{ const unsigned char * buf = (const unsigned char *) s->buf;
+  const unsigned char * end = buf + s->end;
+  for (;;)
+  { const unsigned char * p = (const unsigned char *)
+        skipBlanks(s->buf + s->pos, s->buf + s->end);
+    const unsigned char * q = p;
+    const unsigned char * accPos = NULL;
+    int state = DFA_START, token = ERROR;
+    if (p >= end)
+    { s->tokStart = s->pos = s->end;
+      return ENDFILE;
+    }
+    /* run the DFA for the longest match */
+    while (q < end)
+    { state = dfaNext[state][dfaClass[*q]];
+      if (state == DFA_DEAD) break;
+      q++;
+      if (dfaToken[state])
+      { token = dfaToken[state];
+        accPos = q;
+      }
+    }
+    /* no token starts here: the char alone is an error */
+    if (accPos == NULL)
+    { token = ERROR;
+      accPos = p + 1;
+    }
+    s->tokStart = (int) (p - buf);
+    s->pos = (int) (accPos - buf);
+    if (token == C_COMMENT)
+    { const char * close =
+        skipComment(s->buf + s->pos, s->buf + s->end);
+      if (close == NULL)
+      { s->tokStart = s->pos = s->end;
+        s->inComment = TRUE;
+        return COMMENT_ERROR;
+      }
+      s->pos = (int) (close - s->buf);
+      continue;
+    }
+    if (token == ID)
+      token = keywordLookup((const char *) p, s->pos - s->tokStart);
+    return token;
+  }
+}
+
+/* Function scanResumeComment skips the rest of a
+ * comment that began before the start of the scan.
+ * Returns FALSE if the comment does not close before
+ * the end of the text, which is then all consumed
+ */
+int scanResumeComment( ScanState * s )
+{ const char * close =
+    skipComment(s->buf + s->pos, s->buf + s->end);
+  if (close == NULL)
+  { s->tokStart = s->pos = s->end;
+    s->inComment = TRUE;
+    return FALSE;
+  }
+  s->tokStart = s->pos = (int) (close - s->buf);
+  return TRUE;
+}
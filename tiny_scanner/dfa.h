@@ -0,0 +1,38 @@
+/****************************************************/
+/* File: dfa.h                                      */
+/* Table-driven DFA scanner core for C-             */
+/****************************************************/
+
+#ifndef _DFA_H_
+#define _DFA_H_
+
+/* ScanState holds everything one scan over a
+ * resident buffer needs, so several scans can
+ * run side by side
+ */
+typedef struct
+   { const char * buf; /* text being scanned */
+     int pos;          /* next unscanned position */
+     int end;          /* end of the text */
+     int tokStart;     /* lexeme of the last token is */
+                       /* buf[tokStart .. pos) */
+     int inComment;    /* the text ended inside a comment */
+   } ScanState;
+
+/* Procedure scanInit starts a scan of buf[pos..end) */
+void scanInit( ScanState * s, const char * buf, int pos, int end );
+
+/* Function scanToken returns the next token of the
+ * scan, skipping blanks and comments; ENDFILE at the
+ * end of the text
+ */
+TokenType scanToken( ScanState * s );
+
+/* Function scanResumeComment skips the rest of a
+ * comment that began before the start of the scan.
+ * Returns FALSE if the comment does not close before
+ * the end of the text, which is then all consumed
+ */
+int scanResumeComment( ScanState * s );
+
+#endif
@@ -0,0 +1,417 @@
+/****************************************************/
+/* File: driver.c                                   */
+/* Compiling one or many C- source files, the       */
+/* latter concurrently on a pool of threads         */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "compiler.h"
+#include "cache.h"
+#include "driver.h"
+
+/* set NO_PARSE to TRUE to get a scanner-only compiler */
+#define NO_PARSE FALSE
+/* set NO_ANALYZE to TRUE to get a parser-only compiler */
+#define NO_ANALYZE FALSE
+
+/* set NO_CODE to TRUE to get a compiler that does not
+ * generate code
+ */
+#define NO_CODE FALSE
+
+#include "util.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "arena.h"
+#include "flat.h"
+#include "astfile.h"
+#if NO_PARSE
+#include "scan.h"
+#else
+#include "parse.h"
+#if !NO_ANALYZE
+#include "analyze.h"
+#if !NO_CODE
+#include "cgen.h"
+#endif
+#endif
+#endif
+
+/* without a code generator no code is keyed */
+#ifndef CODEGEN
+#define CODEGEN 0
+#endif
+
+/* Function outputName returns the name of the output
+ * file of pgm ending in suffix: the last path component
+ * of pgm without its extension (from its last '.', if
+ * that is not the first character), followed by suffix.
+ * The outputs are written to the working directory,
+ * whatever directory pgm is in
+ */
+char * outputName( const char * pgm, const char * suffix )
+{ const char * base = strrchr(pgm,'/');
+  const char * dot;
+  int len;
+  char * name;
+  base = base ? base+1 : pgm;
+  dot = strrchr(base,'.');
+  len = dot != NULL && dot != base ? dot-base : (int) strlen(base);
+  name = malloc(len+strlen(suffix)+1);
+  if (name == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  memcpy(name,base,len);
+  strcpy(name+len,suffix);
+  return name;
+}
+
+/* arenaReport prints, if TraceMemory is set, the
+   bytes the phase just run took from the arena and
+   the total so far; *mark is the total before it.
+   The tree and the names in it stay in the arena
+   until compilerReset or compilerFree */
+static void arenaReport( Compiler * cc, const char * phase, size_t * mark )
+{ size_t used, reserved;
+  if (!cc->TraceMemory) return;
+  used = arenaUsed(cc,&reserved);
+  outPrintf(cc->listing,"\nArena after %s: %lu bytes, %lu in all, "
+            "%lu in blocks\n",phase,(unsigned long) (used - *mark),
+            (unsigned long) used,(unsigned long) reserved);
+  *mark = used;
+}
+
+/* Function compileSource runs the compiler phases on
+ * cc, whose source and listing are already set up.
+ * The TM code goes to cc->code if it is set, and to
+ * a new file codefile otherwise; message is set as
+ * for compileFile. Returns 0 if there were no errors
+ */
+int compileSource( Compiler * cc, const char * codefile,
+                   char message[MAXMESSAGE] )
+{ TreeNode * syntaxTree;
+  FlatTree * flatTree = NULL;
+  FILE * code;
+  Out out;
+  size_t mark = 0;
+  message[0] = '\0';
+  outPrintf(cc->listing,"\nTINY COMPILATION: %s\n",cc->pgm);
+#if NO_PARSE
+  if(cc->TraceScan)
+  {
+    int horizontal_divider_len = 60;
+    outPrintf(cc->listing, "\n%-20s%-20s%-20s\n", "line number", "token", "lexeme");
+    for(int i=0; i < horizontal_divider_len; i++)
+      outChar(cc->listing, '=');
+    outChar(cc->listing, '\n');
+  }
+  while (getToken(cc)!=ENDFILE);
+#else
+  syntaxTree = parse(cc);
+  arenaReport(cc,"parse",&mark);
+  if (cc->FlatAST || cc->astFile != NULL)
+  { flatTree = flatten(cc,syntaxTree);
+    if (cc->TraceMemory)
+      outPrintf(cc->listing,"\nFlat tree: %d nodes, %lu bytes\n",
+                flatTree->count,(unsigned long) flatBytes(flatTree));
+  }
+  if (cc->astFile != NULL && !astDump(cc,flatTree,cc->astFile))
+  { snprintf(message,MAXMESSAGE,"Unable to write %s\n",cc->astFile);
+    cc->Error = TRUE;
+  }
+  if (cc->TraceParse) {
+    outStr(cc->listing,"\nSyntax tree:\n");
+    if (cc->FlatAST) flatPrintTree(cc,flatTree);
+    else printTree(cc,syntaxTree);
+  }
+#if !NO_ANALYZE
+  if (! cc->Error)
+  { if (cc->TraceAnalyze) outStr(cc->listing,"\nAnalyzing...\n");
+    analyze(cc,syntaxTree);
+    if (cc->TraceAnalyze) outStr(cc->listing,"\nAnalysis Finished\n");
+    arenaReport(cc,"analyze",&mark);
+  }
+#if !NO_CODE
+  if (! cc->Error)
+  { if (cc->code != NULL)
+      codeGen(cc,syntaxTree,(char *) codefile);
+    else if ((code = fopen(codefile,"w")) == NULL)
+    { snprintf(message,MAXMESSAGE,"Unable to open %s\n",codefile);
+      cc->Error = TRUE;
+    }
+    else
+    { outOpen(&out,code);
+      cc->code = &out;
+      codeGen(cc,syntaxTree,(char *) codefile);
+      outClose(&out);
+      fclose(code);
+      cc->code = NULL;
+    }
+    arenaReport(cc,"code",&mark);
+  }
+#endif
+#endif
+#endif
+  return cc->Error ? 1 : 0;
+}
+
+/* outputFlags returns the flags of cc, the phases
+ * compiled in and the way code is generated, all of
+ * which change the listing or the code, for the
+ * cache key
+ */
+static unsigned outputFlags( Compiler * cc )
+{ return (cc->EchoSource ? 1 : 0) | (cc->TraceScan ? 2 : 0)
+       | (cc->TraceParse ? 4 : 0) | (cc->TraceAnalyze ? 8 : 0)
+       | (cc->TraceCode ? 16 : 0) | (NO_PARSE ? 32 : 0)
+       | (NO_ANALYZE ? 64 : 0) | (NO_CODE ? 128 : 0)
+       | (cc->TraceMemory ? 256 : 0) | (cc->FlatAST ? 512 : 0)
+       | CODEGEN << 10;
+}
+
+/* writeOutput writes len bytes to the file name;
+   returns FALSE if it cannot be written */
+static int writeOutput( const char * name, const char * buf, size_t len )
+{ FILE * f = fopen(name,"w");
+  int ok;
+  if (f == NULL) return FALSE;
+  ok = fwrite(buf,1,len,f) == len;
+  if (fclose(f) != 0) ok = FALSE;
+  return ok;
+}
+
+/* compileCached compiles the source of cc through the
+ * cache: a hit writes the stored listing and code to
+ * target and codefile without scanning or parsing, and
+ * a miss compiles into memory, writes the files and
+ * stores them. Returns the status, like compileFile
+ */
+static int compileCached( Compiler * cc, Cache * cache, const char * target,
+                          const char * codefile, char message[MAXMESSAGE] )
+{ CacheKey key;
+  CacheEntry e;
+  char * listBuf = NULL, * codeBuf = NULL;
+  size_t listLen = 0, codeLen = 0;
+  Out listing, code;
+  int status;
+  cacheKey(&key,cc->pgm,outputFlags(cc),cc->srcBuf,cc->srcLen);
+  if (cacheLookup(cache,&key,&e))
+  { status = e.status;
+    listBuf = (char *) e.listing;
+    listLen = e.listLen;
+    codeBuf = (char *) e.code;
+    codeLen = e.codeLen;
+  }
+  else
+  { outOpen(&listing,NULL);
+    outOpen(&code,NULL);
+    cc->listing = &listing;
+    cc->code = &code;
+    status = compileSource(cc,codefile,message);
+    /* the buffers are taken, and freed below */
+    listBuf = listing.buf;
+    listLen = listing.len;
+    codeBuf = code.buf;
+    codeLen = code.len;
+    cc->listing = cc->code = NULL;
+    e.mem = NULL;
+  }
+  /* no code is generated for a source with errors */
+  if (!writeOutput(target,listBuf,listLen))
+  { snprintf(message,MAXMESSAGE,
+             "Failed to open target txt file : %s %s\n",cc->pgm,target);
+    status = 1;
+  }
+  else if (codeLen > 0 && !writeOutput(codefile,codeBuf,codeLen))
+  { snprintf(message,MAXMESSAGE,"Unable to open %s\n",codefile);
+    status = 1;
+  }
+  else if (e.mem == NULL && message[0] == '\0')
+    cacheStore(cache,&key,status,listBuf,listLen,codeBuf,codeLen);
+  if (e.mem != NULL) free(e.mem);
+  else
+  { free(listBuf);
+    free(codeBuf);
+  }
+  return status;
+}
+
+/* Function compileFile compiles the source file pgm,
+ * writing its listing to <base>_20181605.txt and its
+ * TM code to <pgm>.tm. If cache is not NULL, the
+ * outputs are looked up there first and stored
+ * there after compiling. Nothing is written to stderr:
+ * a message for a file that cannot be read or written
+ * is left in message instead (empty otherwise).
+ * Returns 0 if the file compiled without errors
+ */
+int compileFile( const char * pgm, Cache * cache, char message[MAXMESSAGE] )
+{ Compiler cc;
+  char * target, * codefile, * astfile = NULL;
+  FILE * listFile;
+  Out listing;
+  int status;
+  message[0] = '\0';
+  compilerInit(&cc,pgm);
+  if (cc.MapSource ? !mapSource(&cc,pgm)
+                   : (cc.source = fopen(pgm,"r")) == NULL
+                     || !readSource(&cc,fileno(cc.source)))
+  { snprintf(message,MAXMESSAGE,"File %s not found\n",pgm);
+    if (cc.source != NULL) fclose(cc.source);
+    compilerFree(&cc);
+    return 1;
+  }
+  if ((cc.srcFile = srcFileAdd(&cc,pgm,cc.srcBuf,cc.srcLen)) < 0)
+  { snprintf(message,MAXMESSAGE,"File %s is too large\n",pgm);
+    if (cc.source != NULL) fclose(cc.source);
+    compilerFree(&cc);
+    return 1;
+  }
+  target = outputName(pgm,LISTSUFFIX);
+  codefile = outputName(pgm,".tm");
+  /* the image of its syntax tree is named the same way */
+  if (cc.DumpAST)
+  { astfile = outputName(pgm,".ast");
+    cc.astFile = astfile;
+  }
+  /* the image is not cached, so it is always written */
+  if (cache != NULL && astfile == NULL)
+    status = compileCached(&cc,cache,target,codefile,message);
+  else if ((listFile = fopen(target,"w")) == NULL)
+  { snprintf(message,MAXMESSAGE,
+             "Failed to open target txt file : %s %s\n",pgm,target);
+    status = 1;
+  }
+  else
+  { outOpen(&listing,listFile);
+    cc.listing = &listing;
+    status = compileSource(&cc,codefile,message);
+    outClose(&listing);
+    fclose(listFile);
+  }
+  free(target);
+  free(codefile);
+  free(astfile);
+  if (cc.source != NULL) fclose(cc.source);
+  compilerFree(&cc);
+  return status;
+}
+
+/* the files of a compileFiles run, taken in order
+ * by the workers of the pool
+ */
+typedef struct
+   { char ** pgms;
+     int n;
+     int next;               /* next file to hand out */
+     pthread_mutex_t lock;   /* guards next */
+     Cache * cache;          /* or NULL */
+     int * status;           /* per file */
+     char (* message)[MAXMESSAGE];
+   } Batch;
+
+/* worker compiles files of the batch until none is
+   left */
+static void * worker( void * arg )
+{ Batch * b = arg;
+  for (;;)
+  { int i;
+    pthread_mutex_lock(&b->lock);
+    i = b->next++;
+    pthread_mutex_unlock(&b->lock);
+    if (i >= b->n) break;
+    if (b->status[i]) continue; /* see sameOutputs */
+    b->status[i] = compileFile(b->pgms[i],b->cache,b->message[i]);
+  }
+  return NULL;
+}
+
+/* a file of a compileFiles run, by the name of its
+   listing; its other outputs are named the same way */
+typedef struct
+   { char * name;
+     int index;              /* in pgms */
+   } Output;
+
+static int outputCmp( const void * a, const void * b )
+{ const Output * x = a, * y = b;
+  int c = strcmp(x->name,y->name);
+  return c != 0 ? c : x->index - y->index;
+}
+
+/* sameOutputs marks as failed, with a message, each of
+   the n files in pgms whose outputs would be named like
+   those of an earlier one, so that no two workers write
+   the same file */
+static void sameOutputs( Batch * b )
+{ Output * o = malloc((b->n > 0 ? b->n : 1)*sizeof(Output));
+  int i, first = 0;
+  if (o == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  for (i = 0; i < b->n; i++)
+  { o[i].name = outputName(b->pgms[i],LISTSUFFIX);
+    o[i].index = i;
+  }
+  qsort(o,b->n,sizeof(Output),outputCmp);
+  for (i = 1; i < b->n; i++)
+    if (strcmp(o[i].name,o[first].name) != 0) first = i;
+    else
+    { b->status[o[i].index] = 1;
+      snprintf(b->message[o[i].index],MAXMESSAGE,
+               "Files %s and %s both write %s\n",
+               b->pgms[o[first].index],b->pgms[o[i].index],o[i].name);
+    }
+  for (i = 0; i < b->n; i++) free(o[i].name);
+  free(o);
+}
+
+/* Function compileFiles compiles the n files in pgms
+ * with up to jobs of them in flight at once. Each file
+ * gets its own Compiler and output files, and the
+ * messages of failed files are printed to stderr in
+ * the order of pgms once all are done, so the output
+ * does not depend on jobs. A file whose outputs would
+ * be named like those of an earlier one is reported and
+ * not compiled. cache is passed on to compileFile.
+ * Returns the number of files that failed
+ */
+int compileFiles( char * pgms[], int n, int jobs, Cache * cache )
+{ Batch b;
+  pthread_t * tids;
+  int i, started, failed = 0;
+  if (jobs > n) jobs = n;
+  if (jobs < 1) jobs = 1;
+  b.pgms = pgms;
+  b.n = n;
+  b.next = 0;
+  b.cache = cache;
+  pthread_mutex_init(&b.lock,NULL);
+  b.status = calloc(n > 0 ? n : 1,sizeof(int));
+  b.message = calloc(n > 0 ? n : 1,MAXMESSAGE);
+  tids = malloc(jobs*sizeof(pthread_t));
+  if (b.status == NULL || b.message == NULL || tids == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  sameOutputs(&b);
+  /* the calling thread is one of the workers */
+  for (started = 0; started < jobs-1; started++)
+    if (pthread_create(&tids[started],NULL,worker,&b) != 0)
+      break;
+  worker(&b);
+  for (i = 0; i < started; i++)
+    pthread_join(tids[i],NULL);
+  for (i = 0; i < n; i++)
+  { fputs(b.message[i],stderr);
+    if (b.status[i]) failed++;
+  }
+  pthread_mutex_destroy(&b.lock);
+  free(tids);
+  free(b.message);
+  free(b.status);
+  return failed;
+}
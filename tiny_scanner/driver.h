@@ -0,0 +1,59 @@
+/****************************************************/
+/* File: driver.h                                   */
+/* Compiling one or many C- source files, the       */
+/* latter concurrently on a pool of threads         */
+/****************************************************/
+
+#ifndef _DRIVER_H_
+#define _DRIVER_H_
+
+/* MAXMESSAGE is the size of the buffer for the
+ * message a failed file reports on stderr
+ */
+#define MAXMESSAGE 256
+
+/* LISTSUFFIX follows the base name of a source file
+ * in the name of its listing file
+ */
+#define LISTSUFFIX "_20181605.txt"
+
+/* Function outputName returns a new string holding
+ * the name of the output file of pgm ending in suffix:
+ * the last path component of pgm without its extension,
+ * followed by suffix, so it is in the working directory
+ */
+char * outputName( const char * pgm, const char * suffix );
+
+/* Function compileFile compiles the source file pgm,
+ * writing its listing to <base>_20181605.txt and its
+ * TM code to <base>.tm (see outputName). If cache
+ * is not NULL, the outputs are looked up there first
+ * and stored there after compiling. Nothing is written to stderr:
+ * a message for a file that cannot be read or written
+ * is left in message instead (empty otherwise).
+ * Returns 0 if the file compiled without errors
+ */
+int compileFile( const char * pgm, Cache * cache, char message[MAXMESSAGE] );
+
+/* Function compileSource runs the compiler phases on
+ * cc, whose source and listing are already set up.
+ * The TM code goes to cc->code if it is set, and to
+ * a new file codefile otherwise; message is set as
+ * for compileFile. Returns 0 if there were no errors
+ */
+int compileSource( Compiler * cc, const char * codefile,
+                   char message[MAXMESSAGE] );
+
+/* Function compileFiles compiles the n files in pgms
+ * with up to jobs of them in flight at once. Each file
+ * gets its own Compiler and output files, and the
+ * messages of failed files are printed to stderr in
+ * the order of pgms once all are done, so the output
+ * does not depend on jobs. A file whose outputs would
+ * be named like those of an earlier one is reported and
+ * not compiled. cache is passed on to compileFile.
+ * Returns the number of files that failed
+ */
+int compileFiles( char * pgms[], int n, int jobs, Cache * cache );
+
+#endif
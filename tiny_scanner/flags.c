@@ -0,0 +1,26 @@
+/****************************************************/
+/* File: flags.c                                    */
+/* The default flags of the compiler, shared by     */
+/* main.c and the benches                           */
+/****************************************************/
+
+#include "globals.h"
+
+/* allocate and set the default tracing flags;
+   compilerInit copies them into each Compiler, so
+   a program changes them before calling it */
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = TRUE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int TraceMemory = FALSE;
+
+int MapSource = TRUE;
+int FastSkip = TRUE;
+int PreTokenize = FALSE;
+int LexThreads = 1;
+int AnalyzeThreads = 1;
+int RDParse = FALSE;
+int FlatAST = FALSE;
+int DumpAST = FALSE;
@@ -0,0 +1,379 @@
+/****************************************************/
+/* File: flat.c                                     */
+/* Flat syntax trees: a syntax tree held as         */
+/* contiguous arrays indexed by 32-bit node numbers */
+/* A node takes 20 bytes in the arrays, and one     */
+/* with a name 8 more in the name table, plus the   */
+/* text of each distinct name once, against         */
+/* sizeof(TreeNode) for every node of a TreeNode    */
+/* tree; passes walk the arrays by index instead of */
+/* chasing pointers                                 */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "intern.h"
+#include "walk.h"
+#include "flat.h"
+
+/* the bytes of one node in the per-node arrays */
+#define NODEBYTES (4 * sizeof(unsigned char) + sizeof(SrcLoc) + 3 * sizeof(int))
+
+static void outOfMemory( int n )
+{ fprintf(stderr,"Out of memory for %d flat tree nodes\n",n);
+  exit(1);
+}
+
+/* growNodes makes room for at least need nodes */
+static void growNodes( FlatTree * f, int need )
+{ int cap = f->cap ? f->cap : 1024;
+  while (cap < need) cap *= 2;
+  f->nodekind = realloc(f->nodekind,cap);
+  f->kind = realloc(f->kind,cap);
+  f->slot = realloc(f->slot,cap);
+  f->type = realloc(f->type,cap);
+  f->loc = realloc(f->loc,cap * sizeof(SrcLoc));
+  f->child = realloc(f->child,cap * sizeof(int));
+  f->sibling = realloc(f->sibling,cap * sizeof(int));
+  f->attr = realloc(f->attr,cap * sizeof(int));
+  if (!f->nodekind || !f->kind || !f->slot || !f->type || !f->loc
+      || !f->child || !f->sibling || !f->attr)
+    outOfMemory(cap);
+  f->cap = cap;
+}
+
+/* hasName tells whether a node of this kind is named */
+static int hasName( TreeNode * t )
+{ if (t->nodekind == ExpK)
+    return t->kind.exp == IdK || t->kind.exp == ArrIdK
+           || t->kind.exp == CallK;
+  return t->nodekind == DeclK;
+}
+
+/* an atom already copied into strtab, in an open
+ * addressing table keyed by the hash of the atom
+ */
+struct flatSeen
+   { Atom atom;          /* NULL for an empty slot */
+     int str;
+   };
+
+/* growSeen doubles the table of copied atoms */
+static void growSeen( FlatTree * f )
+{ int cap = f->seenCap ? 2 * f->seenCap : 256, i;
+  struct flatSeen * t = calloc(cap,sizeof(struct flatSeen));
+  if (t == NULL) outOfMemory(cap);
+  for (i = 0; i < f->seenCap; i++)
+    if (f->seen[i].atom != NULL)
+    { unsigned h = atomHash(f->seen[i].atom) & (cap - 1);
+      while (t[h].atom != NULL) h = (h + 1) & (cap - 1);
+      t[h] = f->seen[i];
+    }
+  free(f->seen);
+  f->seen = t;
+  f->seenCap = cap;
+}
+
+/* strOf returns the offset of the text of name in
+ * strtab, copying it there the first time
+ */
+static int strOf( FlatTree * f, Atom name )
+{ unsigned h, mask;
+  int len;
+  if (2 * (f->seenCount + 1) > f->seenCap) growSeen(f);
+  mask = f->seenCap - 1;
+  for (h = atomHash(name) & mask; f->seen[h].atom != NULL; h = (h + 1) & mask)
+    if (f->seen[h].atom == name) return f->seen[h].str;
+  len = atomLength(name) + 1;
+  if (f->strLen + len > f->strCap)
+  { int cap = f->strCap ? f->strCap : 4096;
+    while (cap < f->strLen + len) cap *= 2;
+    f->strtab = realloc(f->strtab,cap);
+    if (f->strtab == NULL) outOfMemory(cap);
+    f->strCap = cap;
+  }
+  memcpy(f->strtab + f->strLen,name,len);
+  f->seen[h].atom = name;
+  f->seen[h].str = f->strLen;
+  f->seenCount++;
+  f->strLen += len;
+  return f->seen[h].str;
+}
+
+/* addName adds the payload of a named node and
+ * returns its index in names[]
+ */
+static int addName( FlatTree * f, Atom name, int size )
+{ if (f->nameCount == f->nameCap)
+  { f->nameCap = f->nameCap ? 2 * f->nameCap : 256;
+    f->names = realloc(f->names,f->nameCap * sizeof(FlatName));
+    if (f->names == NULL) outOfMemory(f->nameCap);
+  }
+  f->names[f->nameCount].str = strOf(f,name);
+  f->names[f->nameCount].size = size;
+  return f->nameCount++;
+}
+
+/* flatNode adds t, a node visited by walkTree, to
+ * the flat tree of cc and links it to the child
+ * before it in the parent, or to the sibling before
+ * it at the top. Each frame keeps the node number in
+ * n and the last child added in local[0]
+ */
+static void flatNode( Compiler * cc, TreeNode * t )
+{ FlatTree * f = cc->flat;
+  WalkFrame * fr = walkFrame(cc,0), * up = walkFrame(cc,1);
+  int n = f->count;
+  if (n == f->cap) growNodes(f,n+1);
+  f->count++;
+  f->nodekind[n] = t->nodekind;
+  f->kind[n] = t->kind.exp;
+  /* up->i is past the child list t is in */
+  f->slot[n] = up != NULL ? up->i - 1 : 0;
+  f->type[n] = t->type;
+  f->loc[n] = t->loc;
+  f->child[n] = FLAT_NONE;
+  f->sibling[n] = FLAT_NONE;
+  if (hasName(t))
+    f->attr[n] = addName(f,t->attr.arrAttr.name,
+                         t->nodekind == DeclK && t->kind.decl == ArrVarK
+                         ? t->attr.arrAttr.size : 0);
+  else if (t->nodekind == ExpK && t->kind.exp == ConstK)
+    f->attr[n] = t->attr.val;
+  else if (t->nodekind == ExpK && t->kind.exp == OpK)
+    f->attr[n] = t->attr.op;
+  else if (t->nodekind == TypeK)
+    f->attr[n] = t->attr.type;
+  else f->attr[n] = 0;
+  if (up == NULL)
+  { /* fr->n is still the sibling before t, if any */
+    if (fr->n != FLAT_NONE) f->sibling[fr->n] = n;
+  }
+  else
+  { if (up->local[0] == FLAT_NONE) f->child[up->n] = n;
+    else f->sibling[up->local[0]] = n;
+    up->local[0] = n;
+  }
+  fr->n = n;
+  fr->local[0] = FLAT_NONE;
+}
+
+/* Function flatten stores the syntax tree t in the
+ * flat tree of cc, which keeps its arrays from one
+ * compilation to the next, and returns it
+ */
+FlatTree * flatten( Compiler * cc, TreeNode * t )
+{ FlatTree * f = cc->flat;
+  if (f == NULL && (f = cc->flat = calloc(1,sizeof(FlatTree))) == NULL)
+    outOfMemory(0);
+  f->count = 0;
+  f->nameCount = 0;
+  f->strLen = 0;
+  /* atoms do not outlive their compilation */
+  if (f->seenCount > 0)
+  { memset(f->seen,0,f->seenCap * sizeof(struct flatSeen));
+    f->seenCount = 0;
+  }
+  walkTree(cc,t,flatNode,NULL,NULL);
+  return f;
+}
+
+/* Function flatChild returns the first node in
+ * child list i of node n, or FLAT_NONE; the others
+ * follow it through sibling[] while slot[] is i
+ */
+int flatChild( FlatTree * f, int n, int i )
+{ int c = f->child[n];
+  while (c != FLAT_NONE && f->slot[c] < i) c = f->sibling[c];
+  return c != FLAT_NONE && f->slot[c] == i ? c : FLAT_NONE;
+}
+
+/* Function flatName returns the name of node n; it
+ * is the same pointer for every node with that name
+ */
+Atom flatName( FlatTree * f, int n )
+{ return f->strtab + f->names[f->attr[n]].str;
+}
+
+/* Procedure flatTraverse applies preProc in preorder
+ * and postProc in postorder to node n, its siblings
+ * and all their descendants, like walkTree (walk.h)
+ * does to a TreeNode tree and on the same stack;
+ * preProc and postProc may be NULL
+ */
+void flatTraverse( Compiler * cc, FlatTree * f, int n,
+                   void (* preProc) (Compiler *, FlatTree *, int),
+                   void (* postProc) (Compiler *, FlatTree *, int) )
+{ struct walk * w;
+  int saved;
+  if (n == FLAT_NONE) return;
+  saved = walkBegin(cc);
+  w = cc->walk;
+  walkPush(cc)->n = n;
+  while (w->depth > w->base)
+  { /* hooks may walk too, so the frame is found again */
+    WalkFrame * fr = &w->stack[w->depth - 1];
+    n = fr->n;
+    if (fr->i < 0)
+    { fr->i = 0;
+      if (preProc != NULL) preProc(cc,f,n);
+      /* the children are one chain, walked in one go */
+      if (f->child[n] != FLAT_NONE)
+      { walkPush(cc)->n = f->child[n];
+        continue;
+      }
+    }
+    if (postProc != NULL) postProc(cc,f,n);
+    fr = &w->stack[w->depth - 1];
+    if (f->sibling[n] != FLAT_NONE)
+    { fr->n = f->sibling[n];
+      fr->i = -1;
+    }
+    else w->depth--;
+  }
+  walkEnd(cc,saved);
+}
+
+/* printName prints label and then name on a line of
+ * its own
+ */
+static void printName( Compiler * cc, const char * label, const char * name )
+{ outStr(cc->listing,label);
+  outStr(cc->listing,name);
+  outChar(cc->listing,'\n');
+}
+
+/* printNode prints node n, indented as deep as it
+ * is in the tree
+ */
+static void printNode( Compiler * cc, FlatTree * f, int n )
+{ int indent = 2 * walkDepth(cc);
+  outSpaces(cc->listing,indent);
+  switch (f->nodekind[n])
+  { case StmtK:
+      switch (f->kind[n])
+      { case IfK: outStr(cc->listing,"If\n"); break;
+        case LoopK: outStr(cc->listing,"While\n"); break;
+        case RetK: outStr(cc->listing,"Return\n"); break;
+        case CompK: outStr(cc->listing,"Compound Statement\n"); break;
+        default: outStr(cc->listing,"Unknown ExpNode kind\n"); break;
+      }
+      break;
+    case ExpK:
+      switch (f->kind[n])
+      { case OpK:
+          switch (f->attr[n])
+          { case PLUS: case MINUS:
+              outStr(cc->listing,"Additive Expression\n");
+              break;
+            case TIMES: case OVER:
+              outStr(cc->listing,"Multiplicative Expression\n");
+              break;
+            default:
+              outStr(cc->listing,"Simple Expression\n");
+              break;
+          }
+          outSpaces(cc->listing,indent);
+          outStr(cc->listing,"  Operator : ");
+          printOpToken(cc,f->attr[n]);
+          break;
+        case ConstK:
+          outStr(cc->listing,"Constant : ");
+          outInt(cc->listing,f->attr[n],0);
+          outChar(cc->listing,'\n');
+          break;
+        case IdK:
+          printName(cc,"Variable : ",flatName(f,n));
+          break;
+        case ArrIdK:
+          printName(cc,"Array ID : ",flatName(f,n));
+          break;
+        case CallK:
+          printName(cc,"Call to ",flatName(f,n));
+          break;
+        case AssignK:
+          outStr(cc->listing,"Assign : =\n");
+          break;
+        default:
+          outStr(cc->listing,"Unknown ExpNode kind\n");
+          break;
+      }
+      break;
+    case DeclK:
+      switch (f->kind[n])
+      { case FuncK:
+          printName(cc,"Function Declare : ",flatName(f,n));
+          break;
+        case VarK:
+          printName(cc,"Variable Declare : ",flatName(f,n));
+          break;
+        case ArrVarK:
+          if (f->names[f->attr[n]].size < 0)
+            printName(cc,"Array Variable Declare : ",flatName(f,n));
+          else
+          { outStr(cc->listing,"Array Variable Allocate : ");
+            outStr(cc->listing,flatName(f,n));
+            outStr(cc->listing," of size ");
+            outInt(cc->listing,f->names[f->attr[n]].size,0);
+            outChar(cc->listing,'\n');
+          }
+          break;
+        case ParamK:
+          printName(cc,"Param : ",flatName(f,n));
+          break;
+        case ArrParamK:
+          printName(cc,"Array Param : ",flatName(f,n));
+          break;
+        default:
+          outStr(cc->listing,"Unknown Declaration Node Kind\n");
+          break;
+      }
+      break;
+    case TypeK:
+      if (f->kind[n] != TypeNameK)
+        outStr(cc->listing,"Unknown Type Node Kind\n");
+      else if (f->attr[n] == INT)
+        outStr(cc->listing,"Type : int\n");
+      else if (f->attr[n] == VOID)
+        outStr(cc->listing,"Type : void\n");
+      else outStr(cc->listing,"Type : Unknown Variable Type\n");
+      break;
+    default:
+      outStr(cc->listing,"Unknown node kind\n");
+      break;
+  }
+}
+
+/* Procedure flatPrintTree prints a flat tree to the
+ * listing file exactly as printTree prints the
+ * tree it was made from
+ */
+void flatPrintTree( Compiler * cc, FlatTree * f )
+{ flatTraverse(cc,f,f->count > 0 ? 0 : FLAT_NONE,printNode,NULL);
+}
+
+/* Function flatBytes returns the bytes the nodes of
+ * f take up in its arrays and string table
+ */
+size_t flatBytes( FlatTree * f )
+{ return f->count * NODEBYTES + f->nameCount * sizeof(FlatName) + f->strLen;
+}
+
+/* Procedure flatFree releases the flat tree of cc */
+void flatFree( Compiler * cc )
+{ FlatTree * f = cc->flat;
+  if (f == NULL) return;
+  free(f->nodekind);
+  free(f->kind);
+  free(f->slot);
+  free(f->type);
+  free(f->loc);
+  free(f->child);
+  free(f->sibling);
+  free(f->attr);
+  free(f->names);
+  free(f->strtab);
+  free(f->seen);
+  free(f);
+  cc->flat = NULL;
+}
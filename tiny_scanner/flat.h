@@ -0,0 +1,95 @@
+/****************************************************/
+/* File: flat.h                                     */
+/* Flat syntax trees: a syntax tree held as         */
+/* contiguous arrays indexed by 32-bit node numbers */
+/****************************************************/
+
+#ifndef _FLAT_H_
+#define _FLAT_H_
+
+/* FLAT_NONE is the node number of no node */
+#define FLAT_NONE (-1)
+
+/* the payload of a node that has a name */
+typedef struct
+   { int str;            /* offset of the name in strtab */
+     int size;           /* array size, for ArrVarK */
+   } FlatName;
+
+/* A FlatTree holds the nodes of a syntax tree in
+ * preorder, node n being the n-th element of each
+ * array; the top-level declarations start at node 0.
+ * The children of a node, in its child lists 0 to
+ * MAXCHILDREN-1 in turn, are one chain: child[n] is
+ * the first and sibling[] leads from each to the next,
+ * with slot[] telling which list a child is in. The
+ * payload of a node is in attr[]: the value of a
+ * ConstK, the operator of an OpK, the type of a
+ * TypeNameK, and for a node with a name the index of
+ * its FlatName in names[]. The text of the names is
+ * in strtab, each distinct name once, so a flat tree
+ * holds no pointers and can be written out and
+ * mapped back in as it is (astfile.h)
+ */
+typedef struct flatTree
+   { int count, cap;           /* nodes */
+     unsigned char * nodekind; /* NodeKind */
+     unsigned char * kind;     /* StmtKind, ExpKind, DeclKind or TypeKind */
+     unsigned char * slot;     /* the child list of the parent it is in */
+     unsigned char * type;     /* ExpType */
+     SrcLoc * loc;
+     int * child;              /* first child, or FLAT_NONE */
+     int * sibling;            /* next child of the parent, or FLAT_NONE */
+     int * attr;
+     FlatName * names;
+     int nameCount, nameCap;
+     char * strtab;            /* NUL-terminated names */
+     int strLen, strCap;
+     struct flatSeen * seen;   /* atom to strtab offset, while flattening */
+     int seenCount, seenCap;
+     int * line;               /* line of each node, in a loaded image */
+     void * map;               /* the mapping of a loaded image, or NULL */
+     size_t mapLen;
+   } FlatTree;
+
+/* Function flatten stores the syntax tree t in the
+ * flat tree of cc, which keeps its arrays from one
+ * compilation to the next, and returns it
+ */
+FlatTree * flatten( Compiler * cc, TreeNode * t );
+
+/* Function flatChild returns the first node in
+ * child list i of node n, or FLAT_NONE; the others
+ * follow it through sibling[] while slot[] is i
+ */
+int flatChild( FlatTree * f, int n, int i );
+
+/* Function flatName returns the name of node n; it
+ * is the same pointer for every node with that name
+ */
+Atom flatName( FlatTree * f, int n );
+
+/* Procedure flatTraverse applies preProc in preorder
+ * and postProc in postorder to node n, its siblings
+ * and all their descendants, like traverse in
+ * analyze.c does to a TreeNode tree
+ */
+void flatTraverse( Compiler * cc, FlatTree * f, int n,
+                   void (* preProc) (Compiler *, FlatTree *, int),
+                   void (* postProc) (Compiler *, FlatTree *, int) );
+
+/* Procedure flatPrintTree prints a flat tree to the
+ * listing file exactly as printTree prints the
+ * tree it was made from
+ */
+void flatPrintTree( Compiler * cc, FlatTree * f );
+
+/* Function flatBytes returns the bytes the nodes of
+ * f take up in its arrays and string table
+ */
+size_t flatBytes( FlatTree * f );
+
+/* Procedure flatFree releases the flat tree of cc */
+void flatFree( Compiler * cc );
+
+#endif
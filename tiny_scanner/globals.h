@@ -17,6 +17,9 @@
 #include <ctype.h>
 #include <string.h>
 
+/* buffered output of the listing and code files */
+#include "out.h"
+
 #ifndef FALSE
 #define FALSE 0
 #endif
@@ -81,11 +84,8 @@ typedef int TokenType;
 //    COMMENT_ERROR
 // } TokenType;
 
-extern FILE *source;  /* source code text file */
-extern FILE *listing; /* listing output text file */
-extern FILE *code;    /* code text file for TM simulator */
-
-extern int lineno; /* source line number for listing */
+/* MAXTOKENLEN is the maximum size of a token */
+#define MAXTOKENLEN 40
 
 /**************************************************/
 /***********   Syntax tree for parsing ************/
@@ -132,14 +132,26 @@ typedef enum
 typedef enum
 {
    Void,
-   Integer
+   Integer,
+   IntArray
 } ExpType;
 
 #define MAXCHILDREN 3
 
+/* An Atom is the single interned copy of a name
+ * (see intern.h); two names are equal exactly when
+ * their atoms are the same pointer
+ */
+typedef const char * Atom;
+
+/* A SrcLoc is a file id and byte offset packed into
+ * 32 bits (see srcloc.h)
+ */
+typedef unsigned int SrcLoc;
+
 struct arrayAttr
 {
-   char *name;
+   Atom name;
    int size;
 };
 
@@ -147,7 +159,7 @@ typedef struct treeNode
 {
    struct treeNode *child[MAXCHILDREN];
    struct treeNode *sibling;
-   int lineno;
+   SrcLoc loc;
    NodeKind nodekind;
    union
    {
@@ -161,16 +173,24 @@ typedef struct treeNode
       TokenType type;
       TokenType op;
       int val;
-      char *name;
+      Atom name;
       struct arrayAttr arrAttr;
    } attr;
    ExpType type; /* for type checking of exps */
+   short need; /* registers its value takes to evaluate (cgen.c) */
+   short pure; /* TRUE if evaluating it neither calls nor assigns */
+   struct symbol * sym; /* the symbol it declares or names, once
+                           analyzed (symtab.h); NULL if none */
 } TreeNode;
 
 /**************************************************/
 /***********   Flags for tracing       ************/
 /**************************************************/
 
+/* These are the defaults each compilation starts
+ * with; compilerInit copies them into the Compiler
+ */
+
 /* EchoSource = TRUE causes the source program to
  * be echoed to the listing file with line numbers
  * during parsing
@@ -199,6 +219,154 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
-/* Error = TRUE prevents further passes if an error occurs */
-extern int Error;
+/* TraceMemory = TRUE causes the bytes taken from
+ * the arena (arena.h) to be printed to the listing
+ * file after each phase
+ */
+extern int TraceMemory;
+
+/* MapSource = TRUE causes the source file to be
+ * memory-mapped; otherwise it is read into memory
+ * through the source stream. Either way it is scanned
+ * in place and lexemes are slices of srcBuf
+ */
+extern int MapSource;
+
+/* FastSkip = TRUE lets the scanners jump over runs
+ * of blanks and over comment bodies with the
+ * vectorized skipBlanks/skipComment instead of
+ * matching them a character at a time. It applies
+ * to the whole process (skipSelect), so it is not
+ * copied into the Compiler
+ */
+extern int FastSkip;
+
+/* PreTokenize = TRUE causes the whole source to be
+ * scanned into the token buffer before parsing
+ * starts, instead of a token at a time on demand
+ */
+extern int PreTokenize;
+
+/* LexThreads > 1 causes PreTokenize to split the
+ * source at newlines and scan up to that many chunks
+ * concurrently; the token stream is the same
+ */
+extern int LexThreads;
+
+/* AnalyzeThreads > 1 causes the bodies of the
+ * functions to be analyzed on up to that many
+ * threads, once the global declarations are; the
+ * listing is the same. TraceAnalyze turns it off
+ */
+extern int AnalyzeThreads;
+
+/* RDParse = TRUE causes the hand-written recursive-
+ * descent parser (rdparse.c) to be used instead of
+ * the Bison one; both build the same syntax tree
+ */
+extern int RDParse;
+
+/* FlatAST = TRUE causes the syntax tree to be copied
+ * into a flat tree (flat.h), contiguous arrays
+ * indexed by node number, for the passes after
+ * parsing to work on
+ */
+extern int FlatAST;
+
+/* DumpAST = TRUE causes the flat syntax tree of each
+ * file to be written, as an image that later runs
+ * can map (astfile.h), to a file named like the TM
+ * code file but ending in .ast
+ */
+extern int DumpAST;
+
+/**************************************************/
+/***********   Compilation context     ************/
+/**************************************************/
+
+/* A Compiler holds all the state of one compilation,
+ * so that several can run at once on different
+ * threads; every phase takes it as its first
+ * parameter. See compiler.h
+ */
+typedef struct compiler
+   { /* files */
+     const char * pgm;  /* source file name */
+     FILE * source;     /* source code text file */
+     Out * listing;     /* listing output text file */
+     Out * code;        /* code text file for TM simulator */
+     Out out;           /* the listing on stdout, until the
+                           caller sets another */
+     const char * astFile; /* image of the tree with DumpAST */
+     int Error;         /* TRUE prevents further passes */
+
+     /* flags, as described above */
+     int EchoSource;
+     int TraceScan;
+     int TraceParse;
+     int TraceAnalyze;
+     int TraceCode;
+     int TraceMemory;
+     int MapSource;
+     int PreTokenize;
+     int LexThreads;
+     int AnalyzeThreads;
+     int RDParse;
+     int FlatAST;
+     int DumpAST;
+
+     /* source text (srcmap.h) and locations in it
+        (srcloc.h) */
+     char * srcBuf;
+     int srcLen;
+     size_t mapLen;     /* -1 when srcBuf was read in */
+     int srcFile;       /* file id of srcBuf */
+     struct srcFiles * files;
+
+     /* interned names (intern.h) */
+     struct internTable * atoms;
+
+     /* syntax tree nodes and strings (arena.h) */
+     struct arena * arena;
+
+     /* flat syntax tree (flat.h) */
+     struct flatTree * flat;
+
+     /* stack for walking syntax trees (walk.h) */
+     struct walk * walk;
+
+     /* scanner (scan.h) */
+     void * scanner;    /* private to the linked scanner */
+     char tokenString[MAXTOKENLEN+1];
+     int tokenOffset;
+     int tokenLength;
+
+     /* token buffer (tokbuf.h) */
+     short * tokKind;
+     int * tokOff;
+     int * tokLen;
+     int tokCount;
+     int tokCap;
+
+     /* parser */
+     Atom savedName;    /* for use in assignments */
+     TreeNode * savedTree; /* syntax tree for parse to return */
+     int nextTok;       /* next buffered token with PreTokenize */
+     int curTok;        /* the token last handed to the parser */
+
+     /* semantic analyzer (symtab.h, analyze.h) */
+     struct symTable * symtab;
+     int location;      /* counter for variable memory locations */
+     struct symbol * function; /* the function being analyzed or
+                                  generated */
+     int funcBody;      /* TRUE until the body of function opens */
+     int frameOffset;   /* the last frame offset taken in function */
+     int * binding;     /* symbol ids buildSymtab keeps for typeCheck */
+     int bindCount, bindCap, bindNext;
+
+     /* code generator (code.h, cgen.h) */
+     int emitLoc;       /* TM location for current instruction */
+     int highEmitLoc;   /* highest TM location emitted so far */
+     int tmpOffset;     /* offset of the next temporary in memory */
+   } Compiler;
 #endif
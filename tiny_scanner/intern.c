@@ -0,0 +1,131 @@
+/****************************************************/
+/* File: intern.c                                   */
+/* Identifier interning: every distinct name is     */
+/* stored once, so names compare by pointer         */
+/* Each Compiler has its own table, so compilations */
+/* on different threads share nothing               */
+/* The table is a chained hash table that doubles   */
+/* when full; atoms are carved out of the arena of */
+/* the compilation (arena.h)                        */
+/****************************************************/
+
+#include <stddef.h>
+#include "globals.h"
+#include "intern.h"
+#include "arena.h"
+
+/* the record behind each atom; an Atom points at str */
+typedef struct AtomRec
+   { struct AtomRec * next; /* next atom in the bucket */
+     unsigned hash;
+     int len;
+     char str[];
+   } AtomRec;
+
+#define REC(a) ((const AtomRec *) ((a) - offsetof(AtomRec,str)))
+
+struct internTable
+   { AtomRec ** table;
+     unsigned tableSize; /* a power of two */
+     unsigned atomCount;
+   };
+
+/* the FNV-1a hash of the len characters at s */
+static unsigned hashName( const char * s, int len )
+{ unsigned h = 2166136261u;
+  int i;
+  for (i = 0; i < len; i++)
+    h = (h ^ (unsigned char) s[i]) * 16777619u;
+  return h;
+}
+
+/* growTable doubles the bucket array, rehashing
+ * from the stored hashes
+ */
+static void growTable( struct internTable * it )
+{ unsigned size = it->tableSize ? it->tableSize * 2 : 1024;
+  AtomRec ** t = calloc(size,sizeof(AtomRec *));
+  unsigned i;
+  if (t == NULL)
+  { fprintf(stderr,"Out of memory for identifiers\n");
+    exit(1);
+  }
+  for (i = 0; i < it->tableSize; i++)
+  { AtomRec * a = it->table[i];
+    while (a != NULL)
+    { AtomRec * next = a->next;
+      a->next = t[a->hash & (size-1)];
+      t[a->hash & (size-1)] = a;
+      a = next;
+    }
+  }
+  free(it->table);
+  it->table = t;
+  it->tableSize = size;
+}
+
+/* Function intern returns the atom for the len
+ * characters at s, adding it to the table of cc the
+ * first time that name is seen
+ */
+Atom intern( Compiler * cc, const char * s, int len )
+{ struct internTable * it = cc->atoms;
+  unsigned h = hashName(s,len);
+  AtomRec * a;
+  if (it == NULL)
+  { it = cc->atoms = calloc(1,sizeof(struct internTable));
+    if (it == NULL)
+    { fprintf(stderr,"Out of memory for identifiers\n");
+      exit(1);
+    }
+  }
+  if (it->table != NULL)
+    for (a = it->table[h & (it->tableSize-1)]; a != NULL; a = a->next)
+      if (a->hash == h && a->len == len && memcmp(a->str,s,len) == 0)
+        return a->str;
+  if (it->atomCount >= it->tableSize) growTable(it);
+  a = arenaAlloc(cc,offsetof(AtomRec,str) + len + 1);
+  a->hash = h;
+  a->len = len;
+  memcpy(a->str,s,len);
+  a->str[len] = '\0';
+  a->next = it->table[h & (it->tableSize-1)];
+  it->table[h & (it->tableSize-1)] = a;
+  it->atomCount++;
+  return a->str;
+}
+
+/* Function atomHash returns the hash of an atom,
+ * computed once when it was interned
+ */
+unsigned atomHash( Atom a )
+{ return REC(a)->hash;
+}
+
+/* Function atomLength returns the length of an atom */
+int atomLength( Atom a )
+{ return REC(a)->len;
+}
+
+/* Procedure internFree releases the table of cc;
+ * the atoms go with the arena
+ */
+void internFree( Compiler * cc )
+{ struct internTable * it = cc->atoms;
+  if (it == NULL) return;
+  free(it->table);
+  free(it);
+  cc->atoms = NULL;
+}
+
+/* Procedure internReset forgets every atom of cc,
+ * before its arena is reset, but keeps the bucket
+ * array, so a long-running process does not
+ * allocate it again
+ */
+void internReset( Compiler * cc )
+{ struct internTable * it = cc->atoms;
+  if (it == NULL || it->table == NULL) return;
+  memset(it->table,0,it->tableSize * sizeof(AtomRec *));
+  it->atomCount = 0;
+}
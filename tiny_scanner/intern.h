@@ -0,0 +1,36 @@
+/****************************************************/
+/* File: intern.h                                   */
+/* Identifier interning: every distinct name is     */
+/* stored once, so names compare by pointer         */
+/****************************************************/
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+/* Function intern returns the atom for the len
+ * characters at s, adding it to the table of cc the
+ * first time that name is seen
+ */
+Atom intern( Compiler * cc, const char * s, int len );
+
+/* Function atomHash returns the hash of an atom,
+ * computed once when it was interned
+ */
+unsigned atomHash( Atom a );
+
+/* Function atomLength returns the length of an atom */
+int atomLength( Atom a );
+
+/* Procedure internFree releases the table of cc;
+ * the atoms go with the arena
+ */
+void internFree( Compiler * cc );
+
+/* Procedure internReset forgets every atom of cc,
+ * before its arena is reset, but keeps the bucket
+ * array, so a long-running process does not
+ * allocate it again
+ */
+void internReset( Compiler * cc );
+
+#endif
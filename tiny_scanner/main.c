@@ -5,115 +5,148 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <unistd.h>
 #include "globals.h"
+#include "cache.h"
+#include "driver.h"
+#include "server.h"
+#include "skip.h"
+#include "compiler.h"
+#include "flat.h"
+#include "astfile.h"
 
-/* set NO_PARSE to TRUE to get a scanner-only compiler */
-#define NO_PARSE FALSE
-/* set NO_ANALYZE to TRUE to get a parser-only compiler */
-#define NO_ANALYZE TRUE
+/* the input files named on the command line */
+static char ** pgms = NULL;
+static int npgms = 0, maxpgms = 0;
 
-/* set NO_CODE to TRUE to get a compiler that does not
- * generate code
- */
-#define NO_CODE FALSE
-
-#include "util.h"
-#if NO_PARSE
-#include "scan.h"
-#else
-#include "parse.h"
-#if !NO_ANALYZE
-#include "analyze.h"
-#if !NO_CODE
-#include "cgen.h"
-#endif
-#endif
-#endif
+/* addFile adds the source file name to pgms; a name
+   without an extension gets .tny, as TINY's did */
+static void addFile( const char * name, int len )
+{ char * pgm = malloc(len+5);
+  if (pgm == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  memcpy(pgm,name,len);
+  pgm[len] = '\0';
+  if (strchr(pgm,'.') == NULL) strcat(pgm,".tny");
+  if (npgms == maxpgms)
+  { maxpgms = maxpgms ? 2*maxpgms : 16;
+    pgms = realloc(pgms,maxpgms*sizeof(char *));
+    if (pgms == NULL)
+    { fprintf(stderr,"Out of memory\n");
+      exit(1);
+    }
+  }
+  pgms[npgms++] = pgm;
+}
 
-/* allocate global variables */
-int lineno = 0;
-FILE * source;
-FILE * listing;
-FILE * code;
+/* addResponseFile adds the file names listed in the
+   response file path, separated by white space */
+static void addResponseFile( const char * path )
+{ FILE * f = fopen(path,"r");
+  char name[4096];
+  if (f == NULL)
+  { fprintf(stderr,"Response file %s not found\n",path);
+    exit(1);
+  }
+  while (fscanf(f,"%4095s",name) == 1)
+    addFile(name,strlen(name));
+  fclose(f);
+}
 
-/* allocate and set tracing flags */
-int EchoSource = FALSE;
-int TraceScan = FALSE;
-int TraceParse = TRUE;
-int TraceAnalyze = FALSE;
-int TraceCode = FALSE;
+static void usage( const char * prog )
+{ fprintf(stderr,"usage: %s [-rd] [-flat] [-ast] [-mem] [-j N] [-at N] [-cache dir [-cachesize MB]]"
+                 " <filename | @responsefile>...\n",prog);
+  fprintf(stderr,"       %s -load <image.ast>...\n",prog);
+  fprintf(stderr,"       %s -serve <socket>\n",prog);
+  exit(1);
+}
 
-int Error = FALSE;
+/* printImages maps the syntax tree images in pgms and
+   prints each to stdout as the listing of its source
+   would show it; returns the number that failed */
+static int printImages( void )
+{ int i, failed = 0;
+  for (i = 0; i < npgms; i++)
+  { const char * reason;
+    FlatTree * f = astLoad(pgms[i],&reason);
+    Compiler cc;
+    if (f == NULL)
+    { fprintf(stderr,"%s: %s\n",pgms[i],reason);
+      failed++;
+      continue;
+    }
+    compilerInit(&cc,astSource(f));
+    outPrintf(cc.listing,"\nTINY COMPILATION: %s\n",cc.pgm);
+    outStr(cc.listing,"\nSyntax tree:\n");
+    flatPrintTree(&cc,f);
+    compilerFree(&cc);
+    astUnload(f);
+  }
+  return failed;
+}
 
 int main( int argc, char * argv[] )
-{ TreeNode * syntaxTree;
-  char pgm[120]; /* source code file name */
-  char temp_tar[120];
-  char *target;
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
-      exit(1);
+{ int jobs = 1, load = FALSE;
+  const char * cacheDir = NULL;
+  long long cacheMB = 256;
+  Cache * cache = NULL;
+  int i, failed;
+  /* the skip routines are shared by every Compiler, so
+     they are chosen once, before any compiling or
+     scanning thread starts; without FastSkip blanks
+     and comments are walked a character at a time */
+  skipSelect(FastSkip ? SkipAVX2 : SkipScalar);
+  if (argc == 3 && strcmp(argv[1],"-serve") == 0)
+    return serveCompiles(argv[2]);
+  for (i = 1; i < argc; i++)
+  { if (strncmp(argv[i],"-j",2) == 0)
+    { const char * n = argv[i][2] ? argv[i]+2 : argv[++i];
+      if (n == NULL || (jobs = atoi(n)) < 0) usage(argv[0]);
+      /* -j 0 uses every processor */
+      if (jobs == 0) jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
     }
-  strcpy(pgm,argv[1]);
-  if (strchr (pgm, '.') == NULL)
-     strcat(pgm,".tny");
-  strcpy(temp_tar,pgm);
-  source = fopen(pgm,"r");
-  if (source==NULL)
-  { fprintf(stderr,"File %s not found\n",pgm);
-    exit(1);
+    /* -at N analyzes the functions of a file on N
+       threads, 0 for every processor */
+    else if (strcmp(argv[i],"-at") == 0 && i+1 < argc)
+    { if ((AnalyzeThreads = atoi(argv[++i])) < 0) usage(argv[0]);
+      if (AnalyzeThreads == 0)
+        AnalyzeThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    /* -rd parses with the recursive-descent parser */
+    else if (strcmp(argv[i],"-rd") == 0)
+      RDParse = TRUE;
+    /* -flat runs the passes on a flat syntax tree */
+    else if (strcmp(argv[i],"-flat") == 0)
+      FlatAST = TRUE;
+    /* -ast writes an image of each syntax tree */
+    else if (strcmp(argv[i],"-ast") == 0)
+      DumpAST = TRUE;
+    /* -load prints images instead of compiling */
+    else if (strcmp(argv[i],"-load") == 0)
+      load = TRUE;
+    /* -mem reports the arena bytes of each phase */
+    else if (strcmp(argv[i],"-mem") == 0)
+      TraceMemory = TRUE;
+    else if (strcmp(argv[i],"-cache") == 0 && i+1 < argc)
+      cacheDir = argv[++i];
+    else if (strcmp(argv[i],"-cachesize") == 0 && i+1 < argc)
+    { if ((cacheMB = atoll(argv[++i])) <= 0) usage(argv[0]);
+    }
+    else if (argv[i][0] == '@')
+      addResponseFile(argv[i]+1);
+    else
+      addFile(argv[i],strlen(argv[i]));
   }
-  target = basename(temp_tar);
-  target = strtok(target, ".");
-  strcat(target,"_20181605.txt");
-  if((listing = fopen(target, "w")) == NULL){
-    fprintf(stderr,"Failed to open target txt file : %s %s\n", pgm, target);
+  if (npgms == 0) usage(argv[0]);
+  if (load) return printImages() ? 1 : 0;
+  if (cacheDir != NULL
+      && (cache = cacheOpen(cacheDir,cacheMB << 20)) == NULL)
+  { fprintf(stderr,"Cannot use cache directory %s\n",cacheDir);
     exit(1);
   }
-  fprintf(listing,"\nTINY COMPILATION: %s\n",pgm);
-#if NO_PARSE
-  if(TraceScan)
-  {
-    int horizontal_divider_len = 60;
-    fprintf(listing, "\n%-20s%-20s%-20s\n", "line number", "token", "lexeme");
-    for(int i=0; i < horizontal_divider_len; i++)
-      fputc('=', listing);
-    fputc('\n', listing);
-  }
-  while (getToken()!=ENDFILE);
-#else
-  syntaxTree = parse();
-  if (TraceParse) {
-    fprintf(listing,"\nSyntax tree:\n");
-    printTree(syntaxTree);
-  }
-#if !NO_ANALYZE
-  if (! Error)
-  { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
-    buildSymtab(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
-    typeCheck(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
-  }
-#if !NO_CODE
-  if (! Error)
-  { char * codefile;
-    int fnlen = strcspn(pgm,".");
-    codefile = (char *) calloc(fnlen+4, sizeof(char));
-    strncpy(codefile,pgm,fnlen);
-    strcat(codefile,".tm");
-    code = fopen(codefile,"w");
-    if (code == NULL)
-    { printf("Unable to open %s\n",codefile);
-      exit(1);
-    }
-    codeGen(syntaxTree,codefile);
-    fclose(code);
-  }
-#endif
-#endif
-#endif
-  fclose(source);
-  return 0;
+  failed = compileFiles(pgms,npgms,jobs,cache);
+  if (cache != NULL) cacheClose(cache,stderr);
+  return failed ? 1 : 0;
 }
-
@@ -0,0 +1,231 @@
+/****************************************************/
+/* File: out.c                                      */
+/* Buffered output of the listing and TM code files */
+/* Everything written goes into one large buffer    */
+/* that reaches the file in a single write call, so */
+/* a listing of millions of lines costs a few dozen */
+/* system calls and no stdio locking per line       */
+/****************************************************/
+
+#include "globals.h"
+#include "out.h"
+
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/* OUTBUF is the size of the buffer of an Out over a
+   file; an Out in memory starts with OUTMEM bytes and
+   doubles as it needs */
+#define OUTBUF (256 * 1024)
+#define OUTMEM 4096
+
+/* Procedure outOpen makes o write to file, or keep its
+ * output in memory if file is NULL. The file is not
+ * closed with o
+ */
+void outOpen( Out * o, FILE * file )
+{ o->buf = NULL;       /* allocated on the first write */
+  o->len = o->cap = 0;
+  o->file = file;
+  /* a memory stream has no descriptor */
+  o->fd = file != NULL ? fileno(file) : -1;
+}
+
+/* writeAll writes the n bytes at p and the m at q to
+   the descriptor fd in as few calls as it can */
+static void writeAll( int fd, const char * p, size_t n,
+                      const char * q, size_t m )
+{ while (n + m > 0)
+  { struct iovec iov[2];
+    int k = 0;
+    ssize_t done;
+    if (n > 0) { iov[k].iov_base = (void *) p; iov[k++].iov_len = n; }
+    if (m > 0) { iov[k].iov_base = (void *) q; iov[k++].iov_len = m; }
+    done = k == 1 ? write(fd,iov[0].iov_base,iov[0].iov_len)
+                  : writev(fd,iov,k);
+    if (done < 0) return;   /* the output is lost, as fprintf's would be */
+    if ((size_t) done >= n)
+    { done -= n;
+      n = 0;
+      q += done;
+      m -= done;
+    }
+    else
+    { p += done;
+      n -= done;
+    }
+  }
+}
+
+/* drain writes the buffer of o and then the n bytes
+   at p to its file */
+static void drain( Out * o, const char * p, size_t n )
+{ if (o->fd >= 0)
+  { /* what stdio holds for the file goes out first */
+    fflush(o->file);
+    writeAll(o->fd,o->buf,o->len,p,n);
+  }
+  else
+  { fwrite(o->buf,1,o->len,o->file);
+    fwrite(p,1,n,o->file);
+  }
+  o->len = 0;
+}
+
+/* room makes room for n more bytes in the buffer of
+   o, which must be less than OUTBUF for one over a
+   file */
+static void room( Out * o, size_t n )
+{ if (o->len + n <= o->cap) return;
+  if (o->buf == NULL)
+  { o->cap = o->file != NULL ? OUTBUF : OUTMEM;
+    if ((o->buf = malloc(o->cap)) == NULL)
+    { fprintf(stderr,"Out of memory for an output buffer\n");
+      exit(1);
+    }
+    if (n <= o->cap) return;
+  }
+  if (o->file != NULL) drain(o,NULL,0);
+  else
+  { size_t cap = o->cap;
+    char * buf;
+    while (cap < o->len + n) cap *= 2;
+    if ((buf = realloc(o->buf,cap)) == NULL)
+    { fprintf(stderr,"Out of memory for %lu bytes of output\n",
+              (unsigned long) cap);
+      exit(1);
+    }
+    o->buf = buf;
+    o->cap = cap;
+  }
+}
+
+/* Procedure outFlush writes the buffer of o to its
+ * file; it does nothing to an Out in memory
+ */
+void outFlush( Out * o )
+{ if (o->file == NULL || o->len == 0) return;
+  drain(o,NULL,0);
+  if (o->fd < 0) fflush(o->file);
+}
+
+/* Procedure outReset empties the buffer of an Out in
+ * memory, keeping its space
+ */
+void outReset( Out * o )
+{ o->len = 0;
+}
+
+/* Procedure outClose flushes o and releases its
+ * buffer
+ */
+void outClose( Out * o )
+{ outFlush(o);
+  free(o->buf);
+  o->buf = NULL;
+  o->len = o->cap = 0;
+}
+
+/* Procedures outMem, outStr and outChar write n
+ * bytes at p, the string s and the character c
+ */
+void outMem( Out * o, const char * p, size_t n )
+{ /* an empty buffer may have no memory at all */
+  if (n == 0) return;
+  if (o->len + n > o->cap && o->file != NULL && n >= OUTBUF / 2)
+  { /* too large to be worth copying: it goes out
+       together with the buffer */
+    drain(o,p,n);
+    return;
+  }
+  room(o,n);
+  memcpy(o->buf + o->len,p,n);
+  o->len += n;
+}
+
+void outStr( Out * o, const char * s )
+{ outMem(o,s,strlen(s));
+}
+
+void outChar( Out * o, int c )
+{ if (o->len == o->cap) room(o,1);
+  o->buf[o->len++] = (char) c;
+}
+
+/* Procedure outSpaces writes n blanks */
+void outSpaces( Out * o, int n )
+{ while (n > 0)
+  { int k = n < OUTBUF / 2 ? n : OUTBUF / 2;
+    room(o,k);
+    memset(o->buf + o->len,' ',k);
+    o->len += k;
+    n -= k;
+  }
+}
+
+/* pad writes the blanks that bring a field of len
+   characters to width, if they go on the side width
+   puts them on: left for left true */
+static void pad( Out * o, int len, int width, int left )
+{ if (left ? width > len : -width > len)
+    outSpaces(o,(left ? width : -width) - len);
+}
+
+/* Procedures outInt and outStrField write v in
+ * decimal and s, padded with blanks to width as
+ * printf would: on the left for a positive width, on
+ * the right for a negative one
+ */
+void outInt( Out * o, int v, int width )
+{ char digits[12];
+  char * p = digits + sizeof(digits);
+  unsigned u = v < 0 ? 0u - (unsigned) v : (unsigned) v;
+  int len;
+  do *--p = (char) ('0' + u % 10); while ((u /= 10) != 0);
+  if (v < 0) *--p = '-';
+  len = digits + sizeof(digits) - p;
+  pad(o,len,width,TRUE);
+  outMem(o,p,len);
+  pad(o,len,width,FALSE);
+}
+
+void outStrField( Out * o, const char * s, int width )
+{ int len = strlen(s);
+  pad(o,len,width,TRUE);
+  outMem(o,s,len);
+  pad(o,len,width,FALSE);
+}
+
+/* Procedure outPrintf writes as fprintf would */
+void outPrintf( Out * o, const char * fmt, ... )
+{ va_list ap;
+  int n;
+  if (o->buf == NULL) room(o,1);
+  va_start(ap,fmt);
+  n = vsnprintf(o->buf + o->len,o->cap - o->len,fmt,ap);
+  va_end(ap);
+  if (n < 0) return;
+  if (o->len + n >= o->cap)
+  { /* it did not fit: make the room and print again,
+       or print it aside if no buffer can hold it */
+    char * s;
+    if (o->file != NULL && (size_t) n + 1 >= OUTBUF)
+    { if ((s = malloc(n + 1)) == NULL)
+      { fprintf(stderr,"Out of memory for %d bytes of output\n",n);
+        exit(1);
+      }
+      va_start(ap,fmt);
+      vsnprintf(s,n + 1,fmt,ap);
+      va_end(ap);
+      outMem(o,s,n);
+      free(s);
+      return;
+    }
+    room(o,n + 1);
+    va_start(ap,fmt);
+    vsnprintf(o->buf + o->len,o->cap - o->len,fmt,ap);
+    va_end(ap);
+  }
+  o->len += n;
+}
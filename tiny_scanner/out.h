@@ -0,0 +1,66 @@
+/****************************************************/
+/* File: out.h                                      */
+/* Buffered output of the listing and TM code files */
+/****************************************************/
+
+#ifndef _OUT_H_
+#define _OUT_H_
+
+/* An Out collects output in a large buffer. One over
+ * a file is flushed to it with a single write (or a
+ * writev, with a large piece that does not fit) when
+ * the buffer fills and when it is closed; one over no
+ * file keeps everything in buf, for the caller to
+ * take. The formatting below is done by hand; only
+ * outPrintf goes through printf
+ */
+typedef struct
+   { char * buf;
+     size_t len, cap;
+     FILE * file;       /* or NULL to keep it in memory */
+     int fd;            /* of file, or -1 to go through stdio */
+   } Out;
+
+/* Procedure outOpen makes o write to file, or keep its
+ * output in memory if file is NULL. The file is not
+ * closed with o
+ */
+void outOpen( Out * o, FILE * file );
+
+/* Procedure outFlush writes the buffer of o to its
+ * file; it does nothing to an Out in memory
+ */
+void outFlush( Out * o );
+
+/* Procedure outReset empties the buffer of an Out in
+ * memory, keeping its space
+ */
+void outReset( Out * o );
+
+/* Procedure outClose flushes o and releases its
+ * buffer
+ */
+void outClose( Out * o );
+
+/* Procedures outMem, outStr and outChar write n
+ * bytes at p, the string s and the character c
+ */
+void outMem( Out * o, const char * p, size_t n );
+void outStr( Out * o, const char * s );
+void outChar( Out * o, int c );
+
+/* Procedure outSpaces writes n blanks */
+void outSpaces( Out * o, int n );
+
+/* Procedures outInt and outStrField write v in
+ * decimal and s, padded with blanks to width as
+ * printf would: on the left for a positive width, on
+ * the right for a negative one
+ */
+void outInt( Out * o, int v, int width );
+void outStrField( Out * o, const char * s, int width );
+
+/* Procedure outPrintf writes as fprintf would */
+void outPrintf( Out * o, const char * fmt, ... );
+
+#endif
@@ -0,0 +1,146 @@
+/****************************************************/
+/* File: plex.c                                     */
+/* Parallel chunked scanning into the token buffer  */
+/****************************************************/
+
+/* Each chunk ends just after a newline, so no token
+ * can straddle two chunks; only a comment can. Every
+ * chunk is first scanned on the guess that it does
+ * not start inside a comment. The guesses are then
+ * checked in order and a chunk that really starts
+ * inside a comment is scanned again.
+ */
+
+#include <pthread.h>
+#include "globals.h"
+#include "dfa.h"
+#include "tokbuf.h"
+#include "plex.h"
+
+/* chunks smaller than this are not worth a thread */
+#define MINCHUNK (64*1024)
+
+typedef struct
+   { const char * buf;  /* the source text */
+     int start, end;    /* chunk is buf[start..end) */
+     int inComment;     /* chunk starts inside a comment */
+     int endsInComment; /* a comment runs past its end */
+     int count, cap;    /* tokens scanned */
+     short * kind;
+     int * off, * len;
+   } Chunk;
+
+/* chunkAppend adds a token to a chunk */
+static void chunkAppend( Chunk * c, TokenType kind, int off, int len )
+{ if (c->count == c->cap)
+  { c->cap = c->cap ? c->cap * 2 : (c->end - c->start) / 4 + 16;
+    c->kind = realloc(c->kind,c->cap * sizeof(short));
+    c->off = realloc(c->off,c->cap * sizeof(int));
+    c->len = realloc(c->len,c->cap * sizeof(int));
+    if (!c->kind || !c->off || !c->len)
+    { fprintf(stderr,"Out of memory for %d tokens\n",c->cap);
+      exit(1);
+    }
+  }
+  c->kind[c->count] = (short) kind;
+  c->off[c->count] = off;
+  c->len[c->count] = len;
+  c->count++;
+}
+
+/* scanChunk scans one chunk from the comment state
+ * in c->inComment, up to and including ENDFILE
+ */
+static void scanChunk( Chunk * c )
+{ ScanState s;
+  TokenType token;
+  c->count = 0;
+  scanInit(&s,c->buf,c->start,c->end);
+  if (c->inComment && !scanResumeComment(&s))
+    chunkAppend(c,COMMENT_ERROR,s.tokStart,0);
+  do
+  { token = scanToken(&s);
+    chunkAppend(c,token,s.tokStart,s.pos - s.tokStart);
+  } while (token != ENDFILE);
+  c->endsInComment = s.inComment;
+}
+
+static void * scanThread( void * arg )
+{ scanChunk((Chunk *) arg);
+  return NULL;
+}
+
+/* Function scanParallel scans the whole source into
+ * the token buffer like scanAll, but splits it at
+ * newlines into up to nthreads chunks that are
+ * scanned concurrently with the DFA scanner core.
+ * Returns the number of tokens
+ */
+int scanParallel( Compiler * cc, int nthreads )
+{ Chunk * chunk;
+  pthread_t * thread;
+  int nchunks, i, pos, total;
+  /* the trace and echo go to the listing in token
+     order, which only the serial scanner gives */
+  if (nthreads > cc->srcLen / MINCHUNK) nthreads = cc->srcLen / MINCHUNK;
+  if (nthreads < 2 || cc->TraceScan || cc->EchoSource) return scanAll(cc);
+  chunk = calloc(nthreads,sizeof(Chunk));
+  thread = malloc(nthreads * sizeof(pthread_t));
+  if (chunk == NULL || thread == NULL)
+  { fprintf(stderr,"Out of memory for %d chunks\n",nthreads);
+    exit(1);
+  }
+  /* split at the first newline after each even share */
+  nchunks = 0;
+  pos = 0;
+  for (i = 1; i <= nthreads && pos < cc->srcLen; i++)
+  { int end = (int) ((long long) cc->srcLen * i / nthreads);
+    if (end <= pos) continue;
+    if (i < nthreads)
+    { const char * nl = memchr(cc->srcBuf + end - 1,'\n',cc->srcLen - end + 1);
+      end = nl ? (int) (nl - cc->srcBuf) + 1 : cc->srcLen;
+    }
+    chunk[nchunks].buf = cc->srcBuf;
+    chunk[nchunks].start = pos;
+    chunk[nchunks].end = end;
+    nchunks++;
+    pos = end;
+  }
+  for (i = 1; i < nchunks; i++)
+    if (pthread_create(&thread[i],NULL,scanThread,&chunk[i]) != 0)
+    { fprintf(stderr,"Cannot start scanner thread\n");
+      exit(1);
+    }
+  scanChunk(&chunk[0]);
+  for (i = 1; i < nchunks; i++)
+    pthread_join(thread[i],NULL);
+  /* carry the comment state through the chunks in
+     order, rescanning any chunk guessed wrongly. A
+     chunk's trailing ENDFILE, and the COMMENT_ERROR
+     of a comment still open at its end, belong only
+     to the last chunk */
+  total = 0;
+  for (i = 0; i < nchunks; i++)
+  { if (i > 0 && chunk[i].inComment != chunk[i-1].endsInComment)
+    { chunk[i].inComment = chunk[i-1].endsInComment;
+      scanChunk(&chunk[i]);
+    }
+    if (i < nchunks-1)
+      chunk[i].count -= chunk[i].endsInComment ? 2 : 1;
+    total += chunk[i].count;
+  }
+  tokReserve(cc,cc->tokCount + total);
+  for (i = 0; i < nchunks; i++)
+  { Chunk * c = &chunk[i];
+    memcpy(cc->tokKind + cc->tokCount,c->kind,c->count * sizeof(short));
+    memcpy(cc->tokOff + cc->tokCount,c->off,c->count * sizeof(int));
+    memcpy(cc->tokLen + cc->tokCount,c->len,c->count * sizeof(int));
+    cc->tokCount += c->count;
+    free(c->kind);
+    free(c->off);
+    free(c->len);
+  }
+  free(chunk);
+  free(thread);
+  return cc->tokCount;
+}
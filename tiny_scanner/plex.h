@@ -0,0 +1,17 @@
+/****************************************************/
+/* File: plex.h                                     */
+/* Parallel chunked scanning into the token buffer  */
+/****************************************************/
+
+#ifndef _PLEX_H_
+#define _PLEX_H_
+
+/* Function scanParallel scans the whole source into
+ * the token buffer like scanAll, but splits it at
+ * newlines into up to nthreads chunks that are
+ * scanned concurrently with the DFA scanner core.
+ * Returns the number of tokens
+ */
+int scanParallel( Compiler * cc, int nthreads );
+
+#endif
@@ -0,0 +1,449 @@
+/****************************************************/
+/* File: rdparse.c                                  */
+/* Hand-written recursive-descent parser for C-     */
+/* Statements and declarations are parsed top-down  */
+/* one procedure per rule, and expressions by Pratt */
+/* parsing on the binding powers of the operators   */
+/****************************************************/
+
+/* The parser follows the Bison one (yacc/cm.y) token
+ * for token, so that the two are interchangeable:
+ *
+ *  - a node is placed at cc->curTok, the furthest
+ *    token fetched when it is built, which is where
+ *    the Bison action that builds it runs: it peeks
+ *    at a token exactly where the LALR parser needs
+ *    a lookahead to choose a reduction;
+ *  - the body of a while is a statement list, which
+ *    runs on as far as statements do, and an else
+ *    belongs to the nearest if;
+ *  - a comparison takes no other comparison as an
+ *    operand, and the left side of = is a variable,
+ *    not a parenthesized one;
+ *  - the first syntax error ends the parse; the tree
+ *    is NULL unless the error is a stray token after
+ *    the last declaration, as Bison has by then
+ *    reduced the program.
+ */
+
+#include <setjmp.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "tokbuf.h"
+#include "srcloc.h"
+#include "rdparse.h"
+
+typedef struct
+   { Compiler * cc;
+     int look;          /* token fetched but not taken, or -1 */
+     TreeNode * var;    /* the last factor, if a bare variable */
+     jmp_buf fail;      /* where a syntax error unwinds to */
+   } Parser;
+
+/* new nodes are placed at the furthest token fetched */
+#define LOC tokLoc(p->cc,p->cc->curTok)
+
+/* binding powers of the binary operators: higher
+   binds tighter, and 0 ends an expression */
+#define RELBP 1
+#define ADDBP 2
+#define MULBP 3
+
+/**************************************************/
+/***********   tokens                  ************/
+/**************************************************/
+
+/* fetch returns the index of the next token, as the
+   Bison parser's yylex does */
+static int fetch( Compiler * cc )
+{ if (cc->PreTokenize)
+  { cc->curTok = cc->nextTok;
+    if (cc->nextTok < cc->tokCount-1) cc->nextTok++;
+  }
+  else
+  { int token = getToken(cc);
+    while (token == C_COMMENT)
+      token = getToken(cc);
+    cc->curTok = tokAppend(cc,token,cc->tokenOffset,cc->tokenLength);
+  }
+  return cc->curTok;
+}
+
+/* peek returns the type of the next token, fetching
+   it if it has not been */
+static TokenType peek( Parser * p )
+{ if (p->look < 0) p->look = fetch(p->cc);
+  return p->cc->tokKind[p->look];
+}
+
+/* take consumes the next token and returns its index */
+static int take( Parser * p )
+{ int t;
+  peek(p);
+  t = p->look;
+  p->look = -1;
+  return t;
+}
+
+/* syntaxError reports the next token as Bison's
+   yyerror does and abandons the parse */
+static void syntaxError( Parser * p )
+{ Compiler * cc = p->cc;
+  outPrintf(cc->listing,"Syntax error at line %d: syntax error\n",
+            locLine(cc,LOC));
+  outStr(cc->listing,"Current token: ");
+  printToken(cc,cc->tokKind[cc->curTok],tokenText(cc,cc->curTok));
+  cc->Error = TRUE;
+  longjmp(p->fail,1);
+}
+
+/* match consumes the next token, which must be of
+   type expected, and returns its index */
+static int match( Parser * p, TokenType expected )
+{ if (peek(p) != expected) syntaxError(p);
+  return take(p);
+}
+
+/* append adds t, if any, to the sibling list from
+   *head to *tail */
+static void append( TreeNode ** head, TreeNode ** tail, TreeNode * t )
+{ if (t == NULL) return;
+  if (*head == NULL) *head = t;
+  else (*tail)->sibling = t;
+  *tail = t;
+}
+
+/**************************************************/
+/***********   expressions             ************/
+/**************************************************/
+
+static TreeNode * expression( Parser * p );
+
+static int bindingPower( TokenType op )
+{ switch (op)
+  { case LT: case LTE: case GT: case GTE: case EQ: case NEQ:
+      return RELBP;
+    case PLUS: case MINUS:
+      return ADDBP;
+    case TIMES: case OVER:
+      return MULBP;
+    default:
+      return 0;
+  }
+}
+
+static TreeNode * args( Parser * p )
+{ TreeNode * head = NULL, * tail = NULL;
+  if (peek(p) == RPAREN) return NULL;
+  append(&head,&tail,expression(p));
+  while (peek(p) == COMMA)
+  { take(p);
+    append(&head,&tail,expression(p));
+  }
+  return head;
+}
+
+/* factor parses a variable, call, number or
+   parenthesized expression, and notes in p->var
+   whether it was a variable */
+static TreeNode * factor( Parser * p )
+{ Compiler * cc = p->cc;
+  TreeNode * t;
+  Atom name;
+  switch (peek(p))
+  { case LPAREN:
+      take(p);
+      t = expression(p);
+      match(p,RPAREN);
+      p->var = NULL;
+      return t;
+    case NUM:
+      t = newExpNode(cc,ConstK,LOC);
+      t->attr.val = tokenValue(cc,take(p));
+      p->var = NULL;
+      return t;
+    case ID:
+      name = tokenAtom(cc,take(p));
+      switch (peek(p))
+      { case LSQUAREB:
+          t = newExpNode(cc,ArrIdK,LOC);
+          t->attr.name = name;
+          take(p);
+          t->child[0] = expression(p);
+          match(p,RSQUAREB);
+          p->var = t;
+          return t;
+        case LPAREN:
+          t = newExpNode(cc,CallK,LOC);
+          t->attr.name = name;
+          take(p);
+          t->child[0] = args(p);
+          match(p,RPAREN);
+          p->var = NULL;
+          return t;
+        default:
+          t = newExpNode(cc,IdK,LOC);
+          t->attr.name = name;
+          p->var = t;
+          return t;
+      }
+    default:
+      syntaxError(p);
+      return NULL;
+  }
+}
+
+/* binary parses operands joined by operators that
+   bind at least as tightly as minBP; the operators
+   associate to the left, except that comparisons
+   do not associate at all */
+static TreeNode * binary( Parser * p, int minBP )
+{ TreeNode * t = factor(p);
+  int bp;
+  while ((bp = bindingPower(peek(p))) > 0 && bp >= minBP)
+  { TreeNode * op = newExpNode(p->cc,OpK,LOC);
+    op->attr.op = p->cc->tokKind[take(p)];
+    op->child[0] = t;
+    op->child[1] = binary(p,bp+1);
+    t = op;
+    if (bp == RELBP && bindingPower(peek(p)) == RELBP)
+      syntaxError(p);
+  }
+  return t;
+}
+
+static TreeNode * expression( Parser * p )
+{ TreeNode * t = binary(p,RELBP);
+  if (peek(p) == ASSIGN)
+  { TreeNode * lhs = t, * rhs;
+    if (lhs != p->var) syntaxError(p);
+    take(p);
+    rhs = expression(p);
+    t = newExpNode(p->cc,AssignK,LOC);
+    t->child[0] = lhs;
+    t->child[1] = rhs;
+  }
+  return t;
+}
+
+/**************************************************/
+/***********   statements              ************/
+/**************************************************/
+
+static TreeNode * statement( Parser * p );
+static TreeNode * compoundStmt( Parser * p );
+
+static int startsStatement( TokenType token )
+{ switch (token)
+  { case SEMICOLON: case LCURLY: case IF: case WHILE: case RETURN:
+    case ID: case NUM: case LPAREN:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* statementList parses statements for as long as
+   the next token can start one */
+static TreeNode * statementList( Parser * p )
+{ TreeNode * head = NULL, * tail = NULL;
+  while (startsStatement(peek(p)))
+    append(&head,&tail,statement(p));
+  return head;
+}
+
+static TreeNode * ifStmt( Parser * p )
+{ TreeNode * test, * then, * other = NULL, * t;
+  take(p);
+  match(p,LPAREN);
+  test = expression(p);
+  match(p,RPAREN);
+  then = statement(p);
+  if (peek(p) == ELSE)
+  { take(p);
+    other = statement(p);
+  }
+  t = newStmtNode(p->cc,IfK,LOC);
+  t->child[0] = test;
+  t->child[1] = then;
+  t->child[2] = other;
+  return t;
+}
+
+static TreeNode * whileStmt( Parser * p )
+{ TreeNode * test, * body, * t;
+  take(p);
+  match(p,LPAREN);
+  test = expression(p);
+  match(p,RPAREN);
+  body = statement(p);
+  t = newStmtNode(p->cc,LoopK,LOC);
+  t->child[0] = test;
+  t->child[1] = body;
+  return t;
+}
+
+static TreeNode * returnStmt( Parser * p )
+{ TreeNode * e = NULL, * t;
+  take(p);
+  if (peek(p) != SEMICOLON) e = expression(p);
+  match(p,SEMICOLON);
+  t = newStmtNode(p->cc,RetK,LOC);
+  t->child[0] = e;
+  return t;
+}
+
+static TreeNode * statement( Parser * p )
+{ TreeNode * t;
+  switch (peek(p))
+  { case LCURLY: return compoundStmt(p);
+    case IF: return ifStmt(p);
+    case WHILE: return whileStmt(p);
+    case RETURN: return returnStmt(p);
+    case SEMICOLON:
+      take(p);
+      return NULL;
+    default:
+      t = expression(p);
+      match(p,SEMICOLON);
+      return t;
+  }
+}
+
+/**************************************************/
+/***********   declarations            ************/
+/**************************************************/
+
+static TreeNode * declaration( Parser * p, int global );
+
+/* typeSpecifier builds the type node for the INT or
+   VOID that must come next */
+static TreeNode * typeSpecifier( Parser * p )
+{ TokenType type = peek(p);
+  TreeNode * t;
+  if (type != INT && type != VOID) syntaxError(p);
+  t = newTypeNode(p->cc,TypeNameK,LOC);
+  t->attr.type = type;
+  take(p);
+  return t;
+}
+
+/* param parses the rest of a parameter of the
+   given type */
+static TreeNode * param( Parser * p, TreeNode * type )
+{ Compiler * cc = p->cc;
+  Atom name = tokenAtom(cc,match(p,ID));
+  TreeNode * t;
+  if (peek(p) == LSQUAREB)
+  { take(p);
+    match(p,RSQUAREB);
+    t = newDeclNode(cc,ArrParamK,LOC);
+    t->attr.arrAttr.name = name;
+    t->attr.arrAttr.size = -1;
+  }
+  else
+  { t = newDeclNode(cc,ParamK,LOC);
+    t->attr.name = name;
+  }
+  t->child[0] = type;
+  return t;
+}
+
+/* params parses a parameter list, or VOID for none */
+static TreeNode * params( Parser * p )
+{ TreeNode * head = NULL, * tail = NULL, * type;
+  if (peek(p) == VOID)
+  { take(p);
+    /* deciding between "(void)" and "(void x" needs
+       the next token, before the type node is made */
+    if (peek(p) == RPAREN) return NULL;
+    type = newTypeNode(p->cc,TypeNameK,LOC);
+    type->attr.type = VOID;
+  }
+  else type = typeSpecifier(p);
+  append(&head,&tail,param(p,type));
+  while (peek(p) == COMMA)
+  { take(p);
+    append(&head,&tail,param(p,typeSpecifier(p)));
+  }
+  return head;
+}
+
+static TreeNode * compoundStmt( Parser * p )
+{ TreeNode * locals = NULL, * tail = NULL, * stmts, * t;
+  match(p,LCURLY);
+  while (peek(p) == INT || peek(p) == VOID)
+    append(&locals,&tail,declaration(p,FALSE));
+  stmts = statementList(p);
+  match(p,RCURLY);
+  t = newStmtNode(p->cc,CompK,LOC);
+  t->child[0] = locals;
+  t->child[1] = stmts;
+  return t;
+}
+
+/* declaration parses a variable declaration, or at
+   global level a function declaration as well */
+static TreeNode * declaration( Parser * p, int global )
+{ Compiler * cc = p->cc;
+  TreeNode * type = typeSpecifier(p), * t;
+  Atom name = tokenAtom(cc,match(p,ID));
+  switch (peek(p))
+  { case SEMICOLON:
+      take(p);
+      t = newDeclNode(cc,VarK,LOC);
+      t->attr.name = name;
+      t->child[0] = type;
+      return t;
+    case LSQUAREB:
+      t = newDeclNode(cc,ArrVarK,LOC);
+      t->attr.arrAttr.name = name;
+      t->child[0] = type;
+      take(p);
+      t->attr.arrAttr.size = tokenValue(cc,match(p,NUM));
+      match(p,RSQUAREB);
+      match(p,SEMICOLON);
+      return t;
+    case LPAREN:
+      if (!global) break;
+      t = newDeclNode(cc,FuncK,LOC);
+      t->attr.name = name;
+      t->child[0] = type;
+      take(p);
+      t->child[1] = params(p);
+      match(p,RPAREN);
+      t->child[2] = compoundStmt(p);
+      return t;
+    default:
+      break;
+  }
+  syntaxError(p);
+  return NULL;
+}
+
+/**************************************************/
+/***********   the parser              ************/
+/**************************************************/
+
+/* Function rdParse parses the source of cc like the
+ * Bison parser (yacc/cm.y) and returns the same
+ * syntax tree, with the same node locations, or
+ * reports the same syntax error at the same token.
+ * Tokens come from the token buffer if it was filled
+ * before parsing, from getToken otherwise
+ */
+TreeNode * rdParse( Compiler * cc )
+{ Parser p;
+  TreeNode * head = NULL, * tail = NULL;
+  p.cc = cc;
+  p.look = -1;
+  p.var = NULL;
+  if (setjmp(p.fail)) return cc->savedTree;
+  do
+    append(&head,&tail,declaration(&p,TRUE));
+  while (peek(&p) == INT || peek(&p) == VOID);
+  cc->savedTree = head;
+  if (peek(&p) != ENDFILE) syntaxError(&p);
+  return cc->savedTree;
+}
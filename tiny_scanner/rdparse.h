@@ -0,0 +1,18 @@
+/****************************************************/
+/* File: rdparse.h                                  */
+/* Hand-written recursive-descent parser for C-     */
+/****************************************************/
+
+#ifndef _RDPARSE_H_
+#define _RDPARSE_H_
+
+/* Function rdParse parses the source of cc like the
+ * Bison parser (yacc/cm.y) and returns the same
+ * syntax tree, with the same node locations, or
+ * reports the same syntax error at the same token.
+ * Tokens come from the token buffer if it was filled
+ * before parsing, from getToken otherwise
+ */
+TreeNode * rdParse( Compiler * cc );
+
+#endif
@@ -1,6 +1,7 @@
 /****************************************************/
 /* File: scan.c                                     */
-/* The scanner implementation for the TINY compiler */
+/* The scanner implementation for the C- compiler   */
+/* (table-driven alternative to lex/tiny.l)         */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,196 +9,71 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "dfa.h"
+#include "srcloc.h"
 
-/* states in scanner DFA */
-typedef enum
-   { START,INASSIGN,INCOMMENT,INNUM,INID,DONE,INCOMPARE }
-   StateType;
+#include <limits.h>
 
-/* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN+1];
+/* the scanner of a compilation, cc->scanner */
+typedef struct
+   { ScanState scan;  /* the scan over srcBuf */
+     int echoPos;     /* start of the first line not yet echoed */
+     int echoLine;    /* and its number */
+   } Scanner;
 
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
-
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
-
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
-    }
-    else
-    { EOF_flag = TRUE;
-      return EOF;
-    }
+/* echoLines echoes the source lines up to and
+   including line last to the listing */
+static void echoLines(Compiler * cc, Scanner * s, int last)
+{ while (s->echoLine <= last && s->echoPos < cc->srcLen)
+  { const char * p = cc->srcBuf + s->echoPos;
+    const char * nl = memchr(p,'\n',cc->srcLen - s->echoPos);
+    int n = nl ? (int)(nl-p)+1 : cc->srcLen - s->echoPos;
+    outInt(cc->listing,s->echoLine,4);
+    outStr(cc->listing,": ");
+    outMem(cc->listing,p,n);
+    s->echoPos += n;
+    s->echoLine++;
   }
-  else return lineBuf[linepos++];
-}
-
-/* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
-
-/* lookup table of reserved words */
-static struct
-    { char* str;
-      TokenType tok;
-    } reservedWords[MAXRESERVED]
-   = {{"if",IF},{"else",ELSE},{"return",RETURN},{"while",WHILE},{"for",FOR}};
-
-/* lookup an identifier to see if it is a reserved word */
-/* uses linear search */
-static TokenType reservedLookup (char * s)
-{ int i;
-  for (i=0;i<MAXRESERVED;i++)
-    if (!strcmp(s,reservedWords[i].str))
-      return reservedWords[i].tok;
-  return ID;
 }
 
 /****************************************/
 /* the primary function of the scanner  */
 /****************************************/
-/* function getToken returns the 
- * next token in source file
+/* function getToken returns the next token in
+ * the source of cc. Its lexeme is the slice
+ * srcBuf[tokenOffset .. tokenOffset+tokenLength);
+ * tokenString is only filled on demand
  */
-TokenType getToken(void)
-{  /* index for storing into tokenString */
-   int tokenStringIndex = 0;
-   /* holds current token to be returned */
-   TokenType currentToken;
-   /* current state - always begins at START */
-   StateType state = START;
-   /* flag to indicate save to tokenString */
-   int save;
-   while (state != DONE)
-   { int c = getNextChar();
-     save = TRUE;
-     switch (state)
-     { case START:
-         if (isdigit(c))
-           state = INNUM;
-         else if (isalpha(c))
-           state = INID;
-         else if (c == ':')
-           state = INASSIGN;
-         else if ((c == '<') || (c == '>'))
-           state = INCOMPARE;
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
-         else if (c == '{')
-         { save = FALSE;
-           state = INCOMMENT;
-         }
-         else
-         { state = DONE;
-           switch (c)
-           { case EOF:
-               save = FALSE;
-               currentToken = ENDFILE;
-               break;
-             case '=':
-               currentToken = EQ;
-               break;
-             case '<':
-               currentToken = LT;
-               break;
-             case '+':
-               currentToken = PLUS;
-               break;
-             case '-':
-               currentToken = MINUS;
-               break;
-             case '*':
-               currentToken = ASTER;
-               break;
-             case '/':
-               currentToken = OVER;
-               break;
-             case '(':
-               currentToken = LPAREN;
-               break;
-             case ')':
-               currentToken = RPAREN;
-               break;
-             case ';':
-               currentToken = SEMICOLON;
-               break;
-             default:
-               currentToken = ERROR;
-               break;
-           }
-         }
-         break;
-       case INCOMMENT:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if (c == '}') state = START;
-         break;
-       case INASSIGN:
-         state = DONE;
-         if (c == '=')
-           currentToken = ASSIGN;
-         else
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           currentToken = ERROR;
-         }
-         break;
-       case INNUM:
-         if (!isdigit(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = NUM;
-         }
-         break;
-       case INID:
-         if (!isalpha(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ID;
-         }
-         break;
-       case DONE:
-       default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
-         state = DONE;
-         currentToken = ERROR;
-         break;
-     }
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-       tokenString[tokenStringIndex++] = (char) c;
-     if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
-       if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
-     }
-   }
-   if (TraceScan) {
-     fprintf(listing,"\t%d: ",lineno);
-     printToken(currentToken,tokenString);
-   }
-   return currentToken;
+TokenType getToken( Compiler * cc )
+{ Scanner * s = cc->scanner;
+  TokenType currentToken;
+  if (s == NULL)
+  { s = cc->scanner = malloc(sizeof(Scanner));
+    if (s == NULL)
+    { fprintf(stderr,"Out of memory for the scanner\n");
+      exit(1);
+    }
+    scanInit(&s->scan,cc->srcBuf,0,cc->srcLen);
+    s->echoPos = 0;
+    s->echoLine = 1;
+  }
+  currentToken = scanToken(&s->scan);
+  cc->tokenOffset = s->scan.tokStart;
+  cc->tokenLength = s->scan.pos - s->scan.tokStart;
+  if (cc->EchoSource)
+    echoLines(cc,s,currentToken == ENDFILE ? INT_MAX
+              : locLine(cc,makeLoc(cc->srcFile,cc->tokenOffset)));
+  if (cc->TraceScan) {
+    outChar(cc->listing,'\t');
+    outInt(cc->listing,locLine(cc,makeLoc(cc->srcFile,cc->tokenOffset)),0);
+    outStr(cc->listing,"\t\t\t");
+    printToken(cc,currentToken,lexemeString(cc));
+  }
+  return currentToken;
 } /* end getToken */
 
+/* Procedure scanFree releases the scanner of cc */
+void scanFree( Compiler * cc )
+{ free(cc->scanner);
+  cc->scanner = NULL;
+}
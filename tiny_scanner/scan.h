@@ -8,15 +8,14 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
-#define MAXTOKENLEN 40
-
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
-
-/* function getToken returns the 
- * next token in source file
+/* function getToken returns the next token in
+ * the source of cc. Its lexeme is the slice
+ * srcBuf[tokenOffset .. tokenOffset+tokenLength);
+ * tokenString is only filled on demand
  */
-TokenType getToken(void);
+TokenType getToken( Compiler * cc );
+
+/* Procedure scanFree releases the scanner of cc */
+void scanFree( Compiler * cc );
 
 #endif
@@ -0,0 +1,194 @@
+/****************************************************/
+/* File: scangen.c                                  */
+/* Build-time generator for the tables of the       */
+/* table-driven C- scanner (dfa.c)                  */
+/* usage: scangen > scantab.h                       */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* states of the scanner DFA; S_DEAD must be 0 */
+typedef enum
+   { S_DEAD, S_START, S_ID, S_NUM, S_MIX,
+     S_LT, S_LTE, S_GT, S_GTE, S_ASSIGN, S_EQ, S_BANG, S_NEQ,
+     S_SLASH, S_COMMENT, S_STAR, S_STAREND,
+     S_PLUS, S_MINUS, S_LPAREN, S_RPAREN, S_LSQUAREB, S_RSQUAREB,
+     S_LCURLY, S_RCURLY, S_SEMICOLON, S_COMMA,
+     NSTATES }
+   StateType;
+
+static const char * stateNames[NSTATES] =
+   { "DEAD", "START", "ID", "NUM", "MIX",
+     "LT", "LTE", "GT", "GTE", "ASSIGN", "EQ", "BANG", "NEQ",
+     "SLASH", "COMMENT", "STAR", "STAREND",
+     "PLUS", "MINUS", "LPAREN", "RPAREN", "LSQUAREB", "RSQUAREB",
+     "LCURLY", "RCURLY", "SEMICOLON", "COMMA" };
+
+#define LETTERS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+#define DIGITS  "0123456789"
+
+/* the transitions of the DFA, mirroring lex/tiny.l:
+ * runs of letters and digits that mix the two are
+ * a single ERROR token, slash-star opens a comment
+ * and a stray star-slash is COMMENT_ERROR
+ */
+static const struct
+   { StateType from;
+     const char * chars;
+     StateType to;
+   } moves[] =
+   { { S_START, LETTERS, S_ID }, { S_START, DIGITS, S_NUM },
+     { S_ID, LETTERS, S_ID }, { S_ID, DIGITS, S_MIX },
+     { S_NUM, DIGITS, S_NUM }, { S_NUM, LETTERS, S_MIX },
+     { S_MIX, LETTERS DIGITS, S_MIX },
+     { S_START, "<", S_LT }, { S_LT, "=", S_LTE },
+     { S_START, ">", S_GT }, { S_GT, "=", S_GTE },
+     { S_START, "=", S_ASSIGN }, { S_ASSIGN, "=", S_EQ },
+     { S_START, "!", S_BANG }, { S_BANG, "=", S_NEQ },
+     { S_START, "/", S_SLASH }, { S_SLASH, "*", S_COMMENT },
+     { S_START, "*", S_STAR }, { S_STAR, "/", S_STAREND },
+     { S_START, "+", S_PLUS }, { S_START, "-", S_MINUS },
+     { S_START, "(", S_LPAREN }, { S_START, ")", S_RPAREN },
+     { S_START, "[", S_LSQUAREB }, { S_START, "]", S_RSQUAREB },
+     { S_START, "{", S_LCURLY }, { S_START, "}", S_RCURLY },
+     { S_START, ";", S_SEMICOLON }, { S_START, ",", S_COMMA } };
+
+/* the token accepted in each final state, by its
+ * name in yacc/cm.y; C_COMMENT marks the start of a
+ * comment body for the scanner
+ */
+static const struct
+   { StateType state;
+     const char * tok;
+   } accepts[] =
+   { { S_ID, "ID" }, { S_NUM, "NUM" }, { S_MIX, "ERROR" },
+     { S_LT, "LT" }, { S_LTE, "LTE" }, { S_GT, "GT" }, { S_GTE, "GTE" },
+     { S_ASSIGN, "ASSIGN" }, { S_EQ, "EQ" }, { S_NEQ, "NEQ" },
+     { S_SLASH, "OVER" }, { S_COMMENT, "C_COMMENT" },
+     { S_STAR, "TIMES" }, { S_STAREND, "COMMENT_ERROR" },
+     { S_PLUS, "PLUS" }, { S_MINUS, "MINUS" },
+     { S_LPAREN, "LPAREN" }, { S_RPAREN, "RPAREN" },
+     { S_LSQUAREB, "LSQUAREB" }, { S_RSQUAREB, "RSQUAREB" },
+     { S_LCURLY, "LCURLY" }, { S_RCURLY, "RCURLY" },
+     { S_SEMICOLON, "SEMICOLON" }, { S_COMMA, "COMMA" } };
+
+/* reserved words, recognized through a perfect hash */
+static const struct
+   { const char * str;
+     const char * tok;
+   } keywords[] =
+   { { "if", "IF" }, { "else", "ELSE" }, { "return", "RETURN" },
+     { "while", "WHILE" }, { "int", "INT" }, { "void", "VOID" } };
+
+#define NMOVES (sizeof(moves)/sizeof(moves[0]))
+#define NACCEPTS (sizeof(accepts)/sizeof(accepts[0]))
+#define NKEYWORDS (sizeof(keywords)/sizeof(keywords[0]))
+
+static int delta[NSTATES][256];
+static int classOf[256];
+static int classRep[256]; /* a member of each class */
+static int nclasses = 0;
+
+/* the keyword hash; must match KW_HASH in the output */
+static unsigned kwHash(const char * s, int len, unsigned a, unsigned b, unsigned mask)
+{ return ((unsigned char) s[0] * a + (unsigned char) s[len-1] * b + len) & mask;
+}
+
+/* buildClasses groups characters whose columns of
+ * delta are identical into one character class;
+ * class 0 is the class of characters no state moves on
+ */
+static void buildClasses(void)
+{ int c, k, s;
+  classRep[nclasses++] = 0;
+  for (c = 0; c < 256; c++)
+  { for (k = 0; k < nclasses; k++)
+    { for (s = 0; s < NSTATES; s++)
+        if (delta[s][c] != delta[s][classRep[k]]) break;
+      if (s == NSTATES) break;
+    }
+    if (k == nclasses) classRep[nclasses++] = c;
+    classOf[c] = k;
+  }
+}
+
+int main(void)
+{ unsigned i, a, b, mask = 0;
+  int c, k, s;
+  int slot[64];
+
+  for (i = 0; i < NMOVES; i++)
+  { const char * p;
+    for (p = moves[i].chars; *p; p++)
+      delta[moves[i].from][(unsigned char) *p] = moves[i].to;
+  }
+  buildClasses();
+
+  /* search the smallest table and multipliers that
+     put every keyword in a slot of its own */
+  for (mask = 7; mask < 64; mask = mask*2+1)
+    for (a = 1; a < 256; a++)
+      for (b = 1; b < 256; b++)
+      { for (k = 0; k <= (int) mask; k++) slot[k] = -1;
+        for (i = 0; i < NKEYWORDS; i++)
+        { const char * w = keywords[i].str;
+          unsigned h = kwHash(w,strlen(w),a,b,mask);
+          if (slot[h] >= 0) break;
+          slot[h] = i;
+        }
+        if (i == NKEYWORDS) goto found;
+      }
+  fprintf(stderr,"scangen: no perfect hash for the keywords\n");
+  return 1;
+found:
+
+  printf("/* scantab.h: tables for the C- scanner in dfa.c */\n");
+  printf("/* generated by scangen - do not edit */\n\n");
+  printf("#define DFA_DEAD 0\n#define DFA_START 1\n");
+  printf("#define DFA_NSTATES %d\n#define DFA_NCLASSES %d\n\n",NSTATES,nclasses);
+
+  printf("/* character classes */\n");
+  printf("static const unsigned char dfaClass[256] =\n   {");
+  for (c = 0; c < 256; c++)
+    printf("%s%2d%s",c % 16 ? "" : "\n     ",classOf[c],c < 255 ? "," : "");
+  printf(" };\n\n");
+
+  printf("/* transitions, by state and character class */\n");
+  printf("static const unsigned char dfaNext[DFA_NSTATES][DFA_NCLASSES] =\n   {");
+  for (s = 0; s < NSTATES; s++)
+  { printf("\n     /* %-9s */ {",stateNames[s]);
+    for (k = 0; k < nclasses; k++)
+      printf("%2d%s",delta[s][classRep[k]],k < nclasses-1 ? "," : "");
+    printf(" }%s",s < NSTATES-1 ? "," : "");
+  }
+  printf(" };\n\n");
+
+  printf("/* token accepted in each state, 0 if none */\n");
+  printf("static const short dfaToken[DFA_NSTATES] =\n   {");
+  for (s = 0; s < NSTATES; s++)
+  { const char * tok = "0";
+    for (i = 0; i < NACCEPTS; i++)
+      if (accepts[i].state == (StateType) s) tok = accepts[i].tok;
+    printf("\n     /* %-9s */ %s%s",stateNames[s],tok,s < NSTATES-1 ? "," : "");
+  }
+  printf(" };\n\n");
+
+  printf("/* perfect hash of the reserved words */\n");
+  printf("#define KW_HASH(s,len) \\\n"
+         "   (((unsigned char) (s)[0] * %uu + (unsigned char) (s)[(len)-1] * %uu + (len)) & %uu)\n\n",
+         a,b,mask);
+  printf("static const struct\n   { const char * str;\n     int len;\n     int tok;\n   } kwTable[%u] =\n   {",
+         mask+1);
+  for (k = 0; k <= (int) mask; k++)
+  { if (slot[k] >= 0)
+      printf("\n     { \"%s\", %d, %s }",keywords[slot[k]].str,
+             (int) strlen(keywords[slot[k]].str),keywords[slot[k]].tok);
+    else
+      printf("\n     { \"\", 0, ID }");
+    printf("%s",k < (int) mask ? "," : "");
+  }
+  printf(" };\n");
+  return 0;
+}
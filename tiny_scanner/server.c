@@ -0,0 +1,294 @@
+/****************************************************/
+/* File: server.c                                   */
+/* Compile server: compiles C- sources sent over a  */
+/* Unix domain socket in one long-running process   */
+/****************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "globals.h"
+#include "compiler.h"
+#include "srcmap.h"
+#include "srcloc.h"
+#include "cache.h"
+#include "driver.h"
+#include "server.h"
+
+/* MAXHEADER bounds the length of a request header */
+#define MAXHEADER 128
+
+/* a connection, read through a buffer */
+typedef struct
+   { int fd;
+     char buf[4096];
+     int pos, len;
+   } Conn;
+
+/* the state kept from one request to the next */
+typedef struct
+   { Compiler cc;
+     Out listing;          /* kept in memory */
+     Out code;
+     char * text;          /* the source of a TEXT request */
+     int textCap;
+     char * name;          /* the path of a PATH request */
+     int nameCap;
+   } Server;
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* grow makes the buffer *p hold at least need bytes */
+static void grow( char ** p, int * cap, int need )
+{ if (need <= *cap) return;
+  free(*p);
+  *cap = need > 2 * *cap ? need : 2 * *cap;
+  *p = malloc(*cap);
+  if (*p == NULL)
+  { fprintf(stderr,"Out of memory for the compile server\n");
+    exit(1);
+  }
+}
+
+/* readBytes reads exactly n bytes from c into dst;
+   returns FALSE at end of input or on an error */
+static int readBytes( Conn * c, char * dst, int n )
+{ while (n > 0)
+  { int k;
+    if (c->pos == c->len)
+    { ssize_t got = read(c->fd,c->buf,sizeof(c->buf));
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) return FALSE;
+      c->pos = 0;
+      c->len = (int) got;
+    }
+    k = c->len - c->pos < n ? c->len - c->pos : n;
+    memcpy(dst,c->buf+c->pos,k);
+    c->pos += k;
+    dst += k;
+    n -= k;
+  }
+  return TRUE;
+}
+
+/* readHeader reads a header line, without its '\n',
+   into line; returns FALSE at end of input or if the
+   line is too long */
+static int readHeader( Conn * c, char line[MAXHEADER] )
+{ int i;
+  for (i = 0; i < MAXHEADER; i++)
+  { if (!readBytes(c,&line[i],1)) return FALSE;
+    if (line[i] == '\n')
+    { line[i] = '\0';
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* writeAll writes the iovcnt buffers of iov to fd;
+   returns FALSE if the peer went away */
+static int writeAll( int fd, struct iovec * iov, int iovcnt )
+{ while (iovcnt > 0)
+  { ssize_t n = writev(fd,iov,iovcnt);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return FALSE;
+    while (iovcnt > 0 && (size_t) n >= iov->iov_len)
+    { n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0)
+    { iov->iov_base = (char *) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return TRUE;
+}
+
+/* setFlags sets the flags of cc from the flags field
+   of a request; returns FALSE for an unknown letter */
+static int setFlags( Compiler * cc, const char * flags )
+{ if (strcmp(flags,"-") == 0) return TRUE;
+  cc->EchoSource = cc->TraceScan = cc->TraceParse = FALSE;
+  cc->TraceAnalyze = cc->TraceCode = cc->TraceMemory = FALSE;
+  for (; *flags; flags++)
+    switch (*flags)
+    { case 'E': cc->EchoSource = TRUE; break;
+      case 'S': cc->TraceScan = TRUE; break;
+      case 'P': cc->TraceParse = TRUE; break;
+      case 'A': cc->TraceAnalyze = TRUE; break;
+      case 'C': cc->TraceCode = TRUE; break;
+      case 'M': cc->TraceMemory = TRUE; break;
+      default: return FALSE;
+    }
+  return TRUE;
+}
+
+/* serveRequest compiles the source of one request,
+   whose payload is already in s->text or s->name, and
+   returns its status; the listing and code are left
+   in the outputs */
+static int serveRequest( Server * s, int isPath, int len, const char * flags )
+{ Compiler * cc = &s->cc;
+  const char * pgm = isPath ? s->name : "<text>";
+  char message[MAXMESSAGE];
+  int status;
+  compilerReset(cc,pgm);
+  cc->listing = &s->listing;
+  cc->code = &s->code;
+  if (!setFlags(cc,flags))
+  { outPrintf(&s->listing,"Unknown flags %s\n",flags);
+    return 2;
+  }
+  if (isPath)
+  { if (!mapSource(cc,pgm))
+    { outPrintf(&s->listing,"File %s not found\n",pgm);
+      return 2;
+    }
+  }
+  else
+  { /* the text is followed by the two NULs flex needs;
+       the server keeps the buffer, so unmapSource must
+       not see it */
+    cc->srcBuf = s->text;
+    cc->srcLen = len;
+  }
+  if ((cc->srcFile = srcFileAdd(cc,pgm,cc->srcBuf,cc->srcLen)) < 0)
+  { outPrintf(&s->listing,"File %s is too large\n",pgm);
+    status = 2;
+  }
+  else
+  { char * codefile = outputName(pgm,".tm");
+    status = compileSource(cc,codefile,message);
+    outStr(&s->listing,message);
+    free(codefile);
+  }
+  if (!isPath) cc->srcBuf = NULL;
+  return status;
+}
+
+/* serveConnection serves the requests on fd until the
+   peer closes it; returns TRUE after a STOP request */
+static int serveConnection( Server * s, int fd )
+{ Conn c;
+  char header[MAXHEADER], kind[8], flags[16], reply[MAXHEADER];
+  struct iovec iov[3];
+  int len, status, stop;
+  double t;
+  c.fd = fd;
+  c.pos = c.len = 0;
+  while (readHeader(&c,header))
+  { t = now();
+    stop = FALSE;
+    if (sscanf(header,"%7s %15s %d",kind,flags,&len) != 3 || len < 0
+        || len > INT_MAX - 2)
+    { outStr(&s->listing,"Bad request header\n");
+      strcpy(kind,"?");
+      len = 0;
+      status = 2;
+      stop = -1;
+    }
+    else if (strcmp(kind,"STOP") == 0)
+    { status = 0;
+      stop = TRUE;
+    }
+    else if (strcmp(kind,"PATH") == 0 || strcmp(kind,"TEXT") == 0)
+    { int isPath = kind[0] == 'P';
+      char ** buf = isPath ? &s->name : &s->text;
+      int * cap = isPath ? &s->nameCap : &s->textCap;
+      grow(buf,cap,len+2);
+      if (!readBytes(&c,*buf,len)) break;
+      (*buf)[len] = (*buf)[len+1] = '\0';
+      status = serveRequest(s,isPath,len,flags);
+    }
+    else
+    { outPrintf(&s->listing,"Unknown request %s\n",kind);
+      status = 2;
+    }
+    t = now() - t;
+    snprintf(reply,sizeof(reply),"%d %lu %lu %ld\n",status,
+             (unsigned long) s->listing.len,(unsigned long) s->code.len,
+             (long) (t * 1e6));
+    iov[0].iov_base = reply;
+    iov[0].iov_len = strlen(reply);
+    iov[1].iov_base = s->listing.buf;
+    iov[1].iov_len = s->listing.len;
+    iov[2].iov_base = s->code.buf;
+    iov[2].iov_len = s->code.len;
+    if (!writeAll(fd,iov,3)) stop = -1;
+    printf("%s %s %d bytes: status %d, %ld usec\n",kind,
+           strcmp(kind,"PATH") == 0 ? s->name : "-",len,status,
+           (long) (t * 1e6));
+    fflush(stdout);
+    /* the outputs keep their buffers; emptying them
+       makes the next request overwrite this one */
+    outReset(&s->listing);
+    outReset(&s->code);
+    if (stop) return stop > 0;
+  }
+  return FALSE;
+}
+
+/* Function serveCompiles listens on the Unix socket
+ * path and serves compile requests, one connection
+ * at a time, until a STOP request. Every request is
+ * compiled with the same Compiler, outputs and
+ * buffers, which are reset rather than reallocated,
+ * and its latency is logged to stdout. Returns 0
+ * after a STOP, nonzero if the socket cannot be set up
+ */
+int serveCompiles( const char * path )
+{ Server s;
+  struct sockaddr_un addr;
+  int sock, fd, done = FALSE;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  { fprintf(stderr,"Socket path %s is too long\n",path);
+    return 1;
+  }
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,path);
+  sock = socket(AF_UNIX,SOCK_STREAM,0);
+  unlink(path);
+  if (sock < 0 || bind(sock,(struct sockaddr *) &addr,sizeof(addr)) < 0
+      || listen(sock,16) < 0)
+  { fprintf(stderr,"Cannot listen on %s: %s\n",path,strerror(errno));
+    return 1;
+  }
+  /* a client that goes away must not kill the server */
+  signal(SIGPIPE,SIG_IGN);
+  memset(&s,0,sizeof(s));
+  compilerInit(&s.cc,"");
+  outOpen(&s.listing,NULL);
+  outOpen(&s.code,NULL);
+  printf("listening on %s\n",path);
+  fflush(stdout);
+  while (!done)
+  { fd = accept(sock,NULL,NULL);
+    if (fd < 0)
+    { if (errno == EINTR) continue;
+      fprintf(stderr,"accept failed: %s\n",strerror(errno));
+      break;
+    }
+    done = serveConnection(&s,fd);
+    close(fd);
+  }
+  close(sock);
+  unlink(path);
+  compilerFree(&s.cc);
+  outClose(&s.listing);
+  outClose(&s.code);
+  free(s.text);
+  free(s.name);
+  return done ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+/****************************************************/
+/* File: server.h                                   */
+/* Compile server: compiles C- sources sent over a  */
+/* Unix domain socket in one long-running process   */
+/****************************************************/
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/* A request is a header line followed by len bytes:
+ *
+ *    PATH <flags> <len>\n<path of the source file>
+ *    TEXT <flags> <len>\n<source text>
+ *    STOP - 0\n
+ *
+ * flags is '-' for the default flags, or the letters
+ * of the flags to turn on, the others being off:
+ * E EchoSource, S TraceScan, P TraceParse,
+ * A TraceAnalyze, C TraceCode, M TraceMemory.
+ *
+ * The reply is a header line followed by the listing
+ * and then the TM code:
+ *
+ *    <status> <listing len> <code len> <usec>\n
+ *
+ * status is 0 if the source compiled, 1 if it had
+ * errors and 2 if the request could not be served
+ * (the listing then holds the reason); usec is the
+ * time the server spent on the request. A connection
+ * may carry any number of requests; STOP shuts the
+ * server down after replying
+ */
+
+/* Function serveCompiles listens on the Unix socket
+ * path and serves compile requests, one connection
+ * at a time, until a STOP request. Every request is
+ * compiled with the same Compiler, outputs and
+ * buffers, which are reset rather than reallocated,
+ * and its latency is logged to stdout. Returns 0
+ * after a STOP, nonzero if the socket cannot be set up
+ */
+int serveCompiles( const char * path );
+
+#endif
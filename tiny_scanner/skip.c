@@ -0,0 +1,166 @@
+/****************************************************/
+/* File: skip.c                                     */
+/* Vectorized whitespace and comment skipping       */
+/* for the C- scanners                              */
+/****************************************************/
+
+#include "skip.h"
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SKIP_X86 1
+#else
+#define SKIP_X86 0
+#endif
+
+/**************************************************/
+/***********   scalar fallback         ************/
+/**************************************************/
+
+static const char * blanksScalar( const char * p, const char * end )
+{ while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+    p++;
+  return p;
+}
+
+static const char * commentScalar( const char * p, const char * end )
+{ for (; p < end; p++)
+    if (*p == '*' && p+1 < end && p[1] == '/')
+      return p+2;
+  return NULL;
+}
+
+#if SKIP_X86
+
+/**************************************************/
+/***********   SSE2, 16 bytes a step   ************/
+/**************************************************/
+
+__attribute__((target("sse2")))
+static const char * blanksSSE2( const char * p, const char * end )
+{ const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  while (end - p >= 16)
+  { __m128i v = _mm_loadu_si128((const __m128i *) p);
+    unsigned blank = _mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v,sp),_mm_cmpeq_epi8(v,lf)),
+        _mm_or_si128(_mm_cmpeq_epi8(v,tab),_mm_cmpeq_epi8(v,cr))));
+    if (blank != 0xFFFFu)
+      return p + __builtin_ctz(~blank);
+    p += 16;
+  }
+  return blanksScalar(p,end);
+}
+
+__attribute__((target("sse2")))
+static const char * commentSSE2( const char * p, const char * end )
+{ const __m128i star = _mm_set1_epi8('*');
+  const __m128i slash = _mm_set1_epi8('/');
+  /* each step also looks one byte ahead for the '/' */
+  while (end - p >= 17)
+  { __m128i v = _mm_loadu_si128((const __m128i *) p);
+    __m128i w = _mm_loadu_si128((const __m128i *) (p+1));
+    unsigned close = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(v,star),_mm_cmpeq_epi8(w,slash)));
+    if (close)
+      return p + __builtin_ctz(close) + 2;
+    p += 16;
+  }
+  return commentScalar(p,end);
+}
+
+/**************************************************/
+/***********   AVX2, 32 bytes a step   ************/
+/**************************************************/
+
+__attribute__((target("avx2")))
+static const char * blanksAVX2( const char * p, const char * end )
+{ const __m256i sp = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  while (end - p >= 32)
+  { __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned blank = (unsigned) _mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v,sp),_mm256_cmpeq_epi8(v,lf)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v,tab),_mm256_cmpeq_epi8(v,cr))));
+    if (blank != 0xFFFFFFFFu)
+      return p + __builtin_ctz(~blank);
+    p += 32;
+  }
+  return blanksSSE2(p,end);
+}
+
+__attribute__((target("avx2")))
+static const char * commentAVX2( const char * p, const char * end )
+{ const __m256i star = _mm256_set1_epi8('*');
+  const __m256i slash = _mm256_set1_epi8('/');
+  while (end - p >= 33)
+  { __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    __m256i w = _mm256_loadu_si256((const __m256i *) (p+1));
+    unsigned close = (unsigned) _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(v,star),_mm256_cmpeq_epi8(w,slash)));
+    if (close)
+      return p + __builtin_ctz(close) + 2;
+    p += 32;
+  }
+  return commentSSE2(p,end);
+}
+
+#endif /* SKIP_X86 */
+
+/**************************************************/
+/***********   dispatch                ************/
+/**************************************************/
+
+typedef const char * (*SkipFn)( const char *, const char * );
+
+static SkipFn blanksFn = NULL;
+static SkipFn commentFn = NULL;
+
+/* Function skipSelect chooses the implementation
+ * used by skipBlanks and skipComment. The best one
+ * the CPU supports is chosen by default; asking for
+ * one it lacks falls back to the next best. Returns
+ * the level actually selected
+ */
+SkipLevel skipSelect( SkipLevel level )
+{
+#if SKIP_X86
+  __builtin_cpu_init();
+  if (level >= SkipAVX2 && __builtin_cpu_supports("avx2"))
+  { blanksFn = blanksAVX2;
+    commentFn = commentAVX2;
+    return SkipAVX2;
+  }
+  if (level >= SkipSSE2 && __builtin_cpu_supports("sse2"))
+  { blanksFn = blanksSSE2;
+    commentFn = commentSSE2;
+    return SkipSSE2;
+  }
+#endif
+  blanksFn = blanksScalar;
+  commentFn = commentScalar;
+  return SkipScalar;
+}
+
+/* Function skipBlanks returns the first position in
+ * [p,end) that is not a blank (' ', '\t', '\r', '\n'),
+ * or end
+ */
+const char * skipBlanks( const char * p, const char * end )
+{ if (blanksFn == NULL) skipSelect(SkipAVX2);
+  return blanksFn(p,end);
+}
+
+/* Function skipComment returns the position just
+ * past the first closing comment delimiter in
+ * [p,end), or NULL if there is none
+ */
+const char * skipComment( const char * p, const char * end )
+{ if (commentFn == NULL) skipSelect(SkipAVX2);
+  return commentFn(p,end);
+}
@@ -0,0 +1,35 @@
+/****************************************************/
+/* File: skip.h                                     */
+/* Vectorized whitespace and comment skipping       */
+/* for the C- scanners                              */
+/****************************************************/
+
+#ifndef _SKIP_H_
+#define _SKIP_H_
+
+/* implementations selectable with skipSelect */
+typedef enum
+   { SkipScalar, SkipSSE2, SkipAVX2 }
+   SkipLevel;
+
+/* Function skipBlanks returns the first position in
+ * [p,end) that is not a blank (' ', '\t', '\r', '\n'),
+ * or end
+ */
+const char * skipBlanks( const char * p, const char * end );
+
+/* Function skipComment returns the position just
+ * past the first closing comment delimiter in
+ * [p,end), or NULL if there is none
+ */
+const char * skipComment( const char * p, const char * end );
+
+/* Function skipSelect chooses the implementation
+ * used by skipBlanks and skipComment. The best one
+ * the CPU supports is chosen by default; asking for
+ * one it lacks falls back to the next best. Returns
+ * the level actually selected
+ */
+SkipLevel skipSelect( SkipLevel level );
+
+#endif
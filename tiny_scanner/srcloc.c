@@ -0,0 +1,180 @@
+/****************************************************/
+/* File: srcloc.c                                   */
+/* Compact source locations for the C- compiler     */
+/* The line table of a file holds the offset at     */
+/* which each of its lines starts; it is built by a */
+/* vectorized newline scan the first time a line or */
+/* column is asked for, and searched by bisection   */
+/****************************************************/
+
+#include "globals.h"
+#include "srcloc.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOC_X86 1
+#else
+#define LOC_X86 0
+#endif
+
+typedef struct
+   { const char * name;
+     const char * buf;
+     int len;
+     int * lineStart; /* built when first asked for */
+     int nlines;      /* 0 until then */
+     int lineCap;     /* room in lineStart, kept across resets */
+   } SrcFileRec;
+
+/* the files of a compilation */
+struct srcFiles
+   { SrcFileRec file[LOC_MAXFILES];
+     int nfiles;
+   };
+
+/* newlinesScalar stores the offset just past each
+ * '\n' in buf[i..len) into starts, unless it is
+ * NULL, and returns how many there are
+ */
+static int newlinesScalar( const char * buf, int i, int len, int * starts )
+{ int n = 0;
+  for (; i < len; i++)
+    if (buf[i] == '\n')
+    { if (starts) starts[n] = i + 1;
+      n++;
+    }
+  return n;
+}
+
+#if LOC_X86
+/* newlinesAVX2 is newlinesScalar 32 bytes a step */
+__attribute__((target("avx2")))
+static int newlinesAVX2( const char * buf, int len, int * starts )
+{ const __m256i lf = _mm256_set1_epi8('\n');
+  int i, n = 0;
+  for (i = 0; i + 32 <= len; i += 32)
+  { unsigned m = (unsigned) _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (buf+i)),lf));
+    if (starts == NULL)
+      n += __builtin_popcount(m);
+    else
+      for (; m != 0; m &= m - 1)
+        starts[n++] = i + __builtin_ctz(m) + 1;
+  }
+  return n + newlinesScalar(buf,i,len,starts ? starts + n : NULL);
+}
+#endif
+
+/* newlines dispatches to the best newline scan */
+static int newlines( const char * buf, int len, int * starts )
+{
+#if LOC_X86
+  if (__builtin_cpu_supports("avx2"))
+    return newlinesAVX2(buf,len,starts);
+#endif
+  return newlinesScalar(buf,0,len,starts);
+}
+
+/* lineTable builds the line table of a file: one
+ * pass counts the lines, a second records where
+ * each one starts
+ */
+static void lineTable( SrcFileRec * f )
+{ int n = newlines(f->buf,f->len,NULL);
+  if (n + 1 > f->lineCap)
+  { free(f->lineStart);
+    f->lineStart = malloc((n + 1) * sizeof(int));
+    if (f->lineStart == NULL)
+    { fprintf(stderr,"Out of memory for the line table of %s\n",f->name);
+      exit(1);
+    }
+    f->lineCap = n + 1;
+  }
+  f->lineStart[0] = 0;
+  newlines(f->buf,f->len,f->lineStart + 1);
+  f->nlines = n + 1;
+}
+
+/* lineIndex returns the index in its file's line
+ * table of the line holding a location
+ */
+static int lineIndex( Compiler * cc, SrcLoc loc, SrcFileRec ** file )
+{ SrcFileRec * f = &cc->files->file[locFile(loc)];
+  int off = locOffset(loc), lo = 0, hi;
+  if (f->nlines == 0) lineTable(f);
+  /* the last line starting at or before off */
+  hi = f->nlines - 1;
+  while (lo < hi)
+  { int mid = (lo + hi + 1) / 2;
+    if (f->lineStart[mid] <= off) lo = mid;
+    else hi = mid - 1;
+  }
+  *file = f;
+  return lo;
+}
+
+/* Function srcFileAdd registers the len bytes at buf
+ * as the text of the file called name and returns
+ * its id, or -1 if there are too many files or the
+ * text is too long for a SrcLoc offset
+ */
+int srcFileAdd( Compiler * cc, const char * name, const char * buf, int len )
+{ SrcFileRec * f;
+  if (cc->files == NULL)
+  { cc->files = calloc(1,sizeof(struct srcFiles));
+    if (cc->files == NULL) return -1;
+  }
+  if (cc->files->nfiles == LOC_MAXFILES || (unsigned) len > LOC_MAXOFFSET)
+    return -1;
+  f = &cc->files->file[cc->files->nfiles];
+  f->name = name;
+  f->buf = buf;
+  f->len = len;
+  f->nlines = 0;
+  return cc->files->nfiles++;
+}
+
+/* Function locFileName returns the name of the file
+ * a location is in
+ */
+const char * locFileName( Compiler * cc, SrcLoc loc )
+{ return cc->files->file[locFile(loc)].name;
+}
+
+/* Function locLine returns the line number of a
+ * location, counting from 1
+ */
+int locLine( Compiler * cc, SrcLoc loc )
+{ SrcFileRec * f;
+  return lineIndex(cc,loc,&f) + 1;
+}
+
+/* Function locColumn returns the column of a
+ * location, counting from 1
+ */
+int locColumn( Compiler * cc, SrcLoc loc )
+{ SrcFileRec * f;
+  int i = lineIndex(cc,loc,&f);
+  return locOffset(loc) - f->lineStart[i] + 1;
+}
+
+/* Procedure srcFilesFree forgets every file of cc
+ * and releases the line tables
+ */
+void srcFilesFree( Compiler * cc )
+{ int i;
+  if (cc->files == NULL) return;
+  for (i = 0; i < LOC_MAXFILES; i++)
+    free(cc->files->file[i].lineStart);
+  free(cc->files);
+  cc->files = NULL;
+  cc->srcFile = 0;
+}
+
+/* Procedure srcFilesReset forgets every file of cc
+ * but keeps the line tables for reuse
+ */
+void srcFilesReset( Compiler * cc )
+{ if (cc->files != NULL) cc->files->nfiles = 0;
+  cc->srcFile = 0;
+}
@@ -0,0 +1,57 @@
+/****************************************************/
+/* File: srcloc.h                                   */
+/* Compact source locations for the C- compiler     */
+/****************************************************/
+
+#ifndef _SRCLOC_H_
+#define _SRCLOC_H_
+
+/* A SrcLoc packs a file id into its top LOC_FILEBITS
+ * bits and a byte offset into that file's source in
+ * the rest; file ids are per Compiler. Line and
+ * column are looked up only when asked for, in a line
+ * table built on first use
+ */
+#define LOC_FILEBITS 4
+#define LOC_OFFBITS (32 - LOC_FILEBITS)
+#define LOC_MAXFILES (1 << LOC_FILEBITS)
+#define LOC_MAXOFFSET ((1u << LOC_OFFBITS) - 1)
+
+#define makeLoc(file,offset) \
+   (((SrcLoc) (file) << LOC_OFFBITS) | (SrcLoc) (offset))
+#define locFile(loc) ((int) ((loc) >> LOC_OFFBITS))
+#define locOffset(loc) ((int) ((loc) & LOC_MAXOFFSET))
+
+/* Function srcFileAdd registers the len bytes at buf
+ * as the text of the file called name and returns
+ * its id, or -1 if there are too many files or the
+ * text is too long for a SrcLoc offset
+ */
+int srcFileAdd( Compiler * cc, const char * name, const char * buf, int len );
+
+/* Function locFileName returns the name of the file
+ * a location is in
+ */
+const char * locFileName( Compiler * cc, SrcLoc loc );
+
+/* Function locLine returns the line number of a
+ * location, counting from 1
+ */
+int locLine( Compiler * cc, SrcLoc loc );
+
+/* Function locColumn returns the column of a
+ * location, counting from 1
+ */
+int locColumn( Compiler * cc, SrcLoc loc );
+
+/* Procedure srcFilesFree forgets every file of cc
+ * and releases the line tables
+ */
+void srcFilesFree( Compiler * cc );
+
+/* Procedure srcFilesReset forgets every file of cc
+ * but keeps the line tables for reuse
+ */
+void srcFilesReset( Compiler * cc );
+
+#endif
@@ -0,0 +1,100 @@
+/****************************************************/
+/* File: srcmap.c                                   */
+/* Memory-mapped source input for the C- compiler   */
+/****************************************************/
+
+#include "globals.h"
+#include "srcmap.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Function readSource reads the rest of the file
+ * open on fd into cc->srcBuf instead of mapping it.
+ * Returns TRUE on success
+ */
+int readSource( Compiler * cc, int fd )
+{ size_t cap = 65536, len = 0;
+  char * buf = malloc(cap);
+  ssize_t n;
+  if (buf == NULL) return FALSE;
+  for (;;)
+  { if (len + 2 >= cap)
+    { char * nbuf = realloc(buf, cap *= 2);
+      if (nbuf == NULL) { free(buf); return FALSE; }
+      buf = nbuf;
+    }
+    n = read(fd, buf + len, cap - len - 2);
+    if (n < 0) { free(buf); return FALSE; }
+    if (n == 0) break;
+    len += n;
+  }
+  buf[len] = buf[len+1] = '\0';
+  cc->srcBuf = buf;
+  cc->srcLen = (int) len;
+  cc->mapLen = (size_t) -1;
+  return TRUE;
+}
+
+/* Function mapSource maps the file named by path
+ * into cc->srcBuf. Files that cannot be mapped
+ * (pipes, character devices) are read into memory
+ * instead. Returns TRUE on success
+ */
+int mapSource( Compiler * cc, const char * path )
+{ struct stat st;
+  long page = sysconf(_SC_PAGESIZE);
+  size_t len, mapLen;
+  char * base;
+  int fd = open(path, O_RDONLY);
+  int ok;
+  if (fd < 0) return FALSE;
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+  { ok = readSource(cc,fd);
+    close(fd);
+    return ok;
+  }
+  if (st.st_size > INT_MAX - 2)
+  { /* token offsets are ints */
+    close(fd);
+    return FALSE;
+  }
+  len = (size_t) st.st_size;
+  /* reserve room for the file plus the two NULs flex
+   * needs, then map the file over the front of it;
+   * the tail of the reservation stays zero-filled even
+   * when the file ends exactly on a page boundary
+   */
+  mapLen = (len + 2 + page - 1) / page * page;
+  base = mmap(NULL, mapLen, PROT_READ|PROT_WRITE,
+              MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+  { close(fd);
+    return FALSE;
+  }
+  if (mmap(base, len, PROT_READ|PROT_WRITE,
+           MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED)
+  { munmap(base, mapLen);
+    close(fd);
+    return FALSE;
+  }
+  close(fd);
+  madvise(base, len, MADV_SEQUENTIAL);
+  cc->srcBuf = base;
+  cc->srcLen = (int) len;
+  cc->mapLen = mapLen;
+  return TRUE;
+}
+
+/* Procedure unmapSource releases cc->srcBuf */
+void unmapSource( Compiler * cc )
+{ if (cc->srcBuf == NULL) return;
+  if (cc->mapLen == (size_t) -1) free(cc->srcBuf);
+  else munmap(cc->srcBuf, cc->mapLen);
+  cc->srcBuf = NULL;
+  cc->srcLen = 0;
+  cc->mapLen = 0;
+}
@@ -0,0 +1,32 @@
+/****************************************************/
+/* File: srcmap.h                                   */
+/* Memory-mapped source input for the C- compiler   */
+/****************************************************/
+
+#ifndef _SRCMAP_H_
+#define _SRCMAP_H_
+
+/* cc->srcBuf holds the whole source file, mapped or
+ * read in, and cc->srcLen is its length. It is
+ * followed by two NUL bytes (not counted in srcLen)
+ * so that it can be handed to flex as a scan buffer
+ * directly
+ */
+
+/* Function mapSource maps the file named by path
+ * into cc->srcBuf. Files that cannot be mapped
+ * (pipes, character devices) are read into memory
+ * instead. Returns TRUE on success
+ */
+int mapSource( Compiler * cc, const char * path );
+
+/* Function readSource reads the rest of the file
+ * open on fd into cc->srcBuf instead of mapping it.
+ * Returns TRUE on success
+ */
+int readSource( Compiler * cc, int fd );
+
+/* Procedure unmapSource releases cc->srcBuf */
+void unmapSource( Compiler * cc );
+
+#endif
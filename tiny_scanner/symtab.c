@@ -1,122 +1,539 @@
 /****************************************************/
 /* File: symtab.c                                   */
 /* Symbol table implementation for the TINY compiler*/
-/* (allows only one symbol table)                   */
-/* Symbol table is implemented as a chained         */
-/* hash table                                       */
+/* (one symbol table per compilation, cc->symtab)  */
+/* Symbol table is implemented as an open          */
+/* addressing hash table of names that grows as it  */
+/* fills, each name with the chain of the           */
+/* declarations it has in the open scopes           */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#include "globals.h"
+#include "intern.h"
+#include "arena.h"
+#include "srcloc.h"
 #include "symtab.h"
 
-/* SIZE is the size of the hash table */
-#define SIZE 211
+/* the table starts with MINSLOTS slots and doubles
+   before it is more than half full */
+#define MINSLOTS 256
 
-/* SHIFT is the power of two used as multiplier
-   in hash function  */
-#define SHIFT 4
+/* the slot of each name in the table: the symbol
+ * it refers to in the current scope, whose shadow
+ * chain holds the ones that symbol hides. A name
+ * keeps its slot once seen, so scopes come and go
+ * without adding or removing slots. The hash of
+ * the name is kept in the slot, so probing and
+ * growing never go back to the atom
+ */
+typedef struct
+   { Atom name;  /* NULL for an empty slot */
+     Symbol * sym; /* NULL when no open scope declares it */
+     unsigned hash;
+   } Slot;
+
+/* a reference in the index by location */
+typedef struct
+   { SrcLoc loc;
+     int sym;    /* the id of the symbol */
+   } LocRef;
+
+/* a reference to a symbol of another table */
+typedef struct
+   { SrcLoc loc;
+     Symbol * sym;
+   } HeldRef;
+
+/* the table of a compilation, cc->symtab: open
+ * addressing with linear probing over a power of
+ * two slots. Every declaration in an open scope is
+ * logged in undo, innermost scope last, and
+ * scopeStart holds where in undo each open scope
+ * begins; exiting a scope pops its declarations off
+ * the log and off the front of their names' shadow
+ * chains. byLoc holds every reference in the
+ * order made, sorted by location when it is first
+ * searched after one out of order.
+ * A table that shares the global scope of another
+ * (st_shareGlobals) numbers its own symbols from
+ * idBase, after those of outer, and keeps the
+ * references to the outer symbols in held
+ */
+struct symTable
+   { Slot * slot;
+     unsigned slotCount, nameCount;
+     int shift;                /* 32 - log2 slotCount */
+     Symbol ** syms;           /* every symbol, by id */
+     int symCount, symCap;
+     LocRef * byLoc;
+     int locCount, locCap, locSorted;
+     Symbol ** undo;
+     int undoCount, undoCap;
+     int * scopeStart;
+     int depth, scopeCap;
+     struct symTable * outer;  /* or NULL */
+     int idBase, visible;      /* outer symbols below visible are seen */
+     HeldRef * held;
+     int heldCount, heldCap;
+   };
+
+/* home returns the slot a hash probes first. Names
+   are atoms, which carry the hash computed when they
+   were interned; multiplying by 2^32 divided by the
+   golden ratio spreads it over the top bits, which
+   pick the slot without a division */
+static unsigned home( struct symTable * st, unsigned hash )
+{ return (hash * 2654435769u) >> st->shift;
+}
+
+/* growTable doubles the slots of st, placing the
+   names again from the hashes in their slots */
+static void growTable( struct symTable * st )
+{ unsigned count = st->slotCount ? 2 * st->slotCount : MINSLOTS;
+  Slot * old = st->slot;
+  unsigned i, mask = count - 1;
+  st->slot = calloc(count,sizeof(Slot));
+  if (st->slot == NULL)
+  { fprintf(stderr,"Out of memory for the symbol table\n");
+    exit(1);
+  }
+  for (st->shift = 32; (1u << (32 - st->shift)) < count; st->shift--)
+    ;
+  for (i = 0; i < st->slotCount; i++)
+    if (old[i].name != NULL)
+    { unsigned h = home(st,old[i].hash);
+      while (st->slot[h].name != NULL) h = (h + 1) & mask;
+      st->slot[h] = old[i];
+    }
+  st->slotCount = count;
+  free(old);
+}
+
+/* symtabOf returns the table of cc, allocating
+   it on first use */
+static struct symTable * symtabOf( Compiler * cc )
+{ if (cc->symtab == NULL)
+  { cc->symtab = calloc(1,sizeof(struct symTable));
+    if (cc->symtab == NULL)
+    { fprintf(stderr,"Out of memory for the symbol table\n");
+      exit(1);
+    }
+    cc->symtab->locSorted = TRUE;
+    growTable(cc->symtab);
+  }
+  return cc->symtab;
+}
+
+/* growArray makes room for element n of the array p
+   of *cap elements of size bytes, doubling it */
+static void * growArray( void * p, int * cap, int n, size_t size )
+{ if (n >= *cap)
+  { do *cap = *cap ? 2 * *cap : 64; while (n >= *cap);
+    if ((p = realloc(p,*cap * size)) == NULL)
+    { fprintf(stderr,"Out of memory for the symbol table\n");
+      exit(1);
+    }
+  }
+  return p;
+}
+
+/* find returns the slot of name in st, or the empty
+   slot where it would go */
+static Slot * find( struct symTable * st, Atom name )
+{ unsigned hash = atomHash(name);
+  unsigned h = home(st,hash), mask = st->slotCount - 1;
+  Slot * l;
+  while ((l = &st->slot[h])->name != NULL
+         && (l->hash != hash || l->name != name))
+    h = (h + 1) & mask;
+  return l;
+}
+
+/* slotOf returns the slot of name, adding it if it
+   has none */
+static Slot * slotOf( Compiler * cc, Atom name )
+{ struct symTable * st = symtabOf(cc);
+  Slot * l = find(st,name);
+  if (l->name == NULL) /* name not yet in table */
+  { if (2 * (st->nameCount + 1) > st->slotCount)
+    { growTable(st);
+      l = find(st,name);
+    }
+    l->name = name;
+    l->hash = atomHash(name);
+    st->nameCount++;
+  }
+  return l;
+}
+
+/* Procedure st_enterScope opens a scope inside the
+ * current one
+ */
+void st_enterScope( Compiler * cc )
+{ struct symTable * st = symtabOf(cc);
+  st->scopeStart = growArray(st->scopeStart,&st->scopeCap,st->depth,
+                             sizeof(int));
+  st->scopeStart[st->depth++] = st->undoCount;
+}
+
+/* Procedure st_exitScope closes the current scope,
+ * so the names declared in it refer again to what
+ * they hid; its cost is the number of them
+ */
+void st_exitScope( Compiler * cc )
+{ struct symTable * st = symtabOf(cc);
+  int start;
+  if (st->depth == 0) return;
+  start = st->scopeStart[--st->depth];
+  while (st->undoCount > start)
+  { Symbol * s = st->undo[--st->undoCount];
+    find(st,s->name)->sym = s->shadow;
+  }
+}
+
+/* Function st_depth returns the depth of the current
+ * scope, 0 for the global one
+ */
+int st_depth( Compiler * cc )
+{ return cc->symtab != NULL ? cc->symtab->depth : 0;
+}
+
+/* Function st_declare declares name in the current
+ * scope and returns its symbol, or NULL if name is
+ * already declared in that scope
+ */
+Symbol * st_declare( Compiler * cc, Atom name, DeclKind kind,
+                     ExpType type, int size, int offset, TreeNode * decl )
+{ struct symTable * st = symtabOf(cc);
+  Slot * l = slotOf(cc,name);
+  Symbol * s;
+  /* a symbol of an exited scope is off the chain, so
+     one at this depth is of this scope */
+  if (l->sym != NULL && l->sym->scope == st->depth) return NULL;
+  s = arenaAlloc(cc,sizeof(Symbol));
+  s->name = name;
+  s->kind = kind;
+  s->type = type;
+  s->size = size;
+  s->offset = offset;
+  s->scope = st->depth;
+  s->decl = decl;
+  s->id = st->idBase + st->symCount;
+  s->refCount = 0;
+  s->lastRef = 0;
+  s->refs = s->refTail = NULL;
+  s->shadow = l->sym;
+  l->sym = s;
+  st->syms = growArray(st->syms,&st->symCap,st->symCount,sizeof(Symbol *));
+  st->syms[st->symCount++] = s;
+  /* the global scope is never exited */
+  if (st->depth > 0)
+  { st->undo = growArray(st->undo,&st->undoCap,st->undoCount,
+                         sizeof(Symbol *));
+    st->undo[st->undoCount++] = s;
+  }
+  return s;
+}
+
+/* Function st_find returns the symbol name refers
+ * to in the current scope, or NULL if it is not
+ * declared
+ */
+Symbol * st_find( Compiler * cc, Atom name )
+{ struct symTable * st = symtabOf(cc);
+  Symbol * s = find(st,name)->sym;
+  if (s == NULL && st->outer != NULL)
+  { s = find(st->outer,name)->sym;
+    if (s != NULL && s->id >= st->visible) s = NULL;
+  }
+  return s;
+}
 
-/* the hash function */
-static int hash ( char * key )
-{ int temp = 0;
-  int i = 0;
-  while (key[i] != '\0')
-  { temp = ((temp << SHIFT) + key[i]) % SIZE;
-    ++i;
+/* newBlock starts the next block of the references
+   to s, twice the size of the last one */
+static RefBlock * newBlock( Compiler * cc, Symbol * s )
+{ int size = s->refTail == NULL ? 16 : 2 * s->refTail->size;
+  RefBlock * b;
+  if (size > REFBLOCK) size = REFBLOCK;
+  b = arenaAlloc(cc,sizeof(RefBlock) + size);
+  b->next = NULL;
+  b->used = 0;
+  b->size = size;
+  if (s->refTail == NULL) s->refs = b;
+  else s->refTail->next = b;
+  s->refTail = b;
+  return b;
+}
+
+/* Procedure st_reference records a reference to
+ * symbol s at location at
+ */
+void st_reference( Compiler * cc, Symbol * s, SrcLoc at )
+{ struct symTable * st = symtabOf(cc);
+  RefBlock * b = s->refTail;
+  if (s->id < st->idBase)
+  { st->held = growArray(st->held,&st->heldCap,st->heldCount,sizeof(HeldRef));
+    st->held[st->heldCount].loc = at;
+    st->held[st->heldCount++].sym = s;
+    return;
+  }
+  /* the difference from the last reference, folded
+     so that small steps back are small too, goes in
+     7 bits a byte, the high bit set on all but the
+     last byte */
+  int d = (int) (at - s->lastRef);
+  unsigned v = ((unsigned) d << 1) ^ (unsigned) (d >> 31);
+  if (b == NULL || b->used + 5 > b->size) b = newBlock(cc,s);
+  while (v >= 0x80)
+  { b->bytes[b->used++] = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  b->bytes[b->used++] = (unsigned char) v;
+  s->lastRef = at;
+  s->refCount++;
+  st->byLoc = growArray(st->byLoc,&st->locCap,st->locCount,sizeof(LocRef));
+  if (st->locCount > 0 && at < st->byLoc[st->locCount-1].loc)
+    st->locSorted = FALSE;
+  st->byLoc[st->locCount].loc = at;
+  st->byLoc[st->locCount++].sym = s->id;
+}
+
+/* Procedure st_firstRef sets c before the first
+ * reference to s
+ */
+void st_firstRef( const Symbol * s, RefCursor * c )
+{ c->block = s->refs;
+  c->pos = 0;
+  c->loc = 0;
+}
+
+/* Function st_nextRef moves c to the next reference,
+ * in the order they were recorded, and returns TRUE
+ * with its location in *at, or FALSE if there are no
+ * more
+ */
+int st_nextRef( RefCursor * c, SrcLoc * at )
+{ unsigned v = 0;
+  int shift = 0;
+  unsigned char byte;
+  if (c->block != NULL && c->pos == c->block->used)
+  { c->block = c->block->next;
+    c->pos = 0;
   }
-  return temp;
+  if (c->block == NULL) return FALSE;
+  do
+  { byte = c->block->bytes[c->pos++];
+    v |= (unsigned) (byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  c->loc += (v >> 1) ^ -(v & 1);
+  *at = c->loc;
+  return TRUE;
+}
+
+/* byLocation orders references by location, for qsort */
+static int byLocation( const void * a, const void * b )
+{ SrcLoc x = ((const LocRef *) a)->loc, y = ((const LocRef *) b)->loc;
+  return x < y ? -1 : x > y;
+}
+
+/* Function st_symbolAt returns the symbol referenced
+ * at location at, or else the one referenced last
+ * before it in that file, or NULL if there is none
+ */
+Symbol * st_symbolAt( Compiler * cc, SrcLoc at )
+{ struct symTable * st = symtabOf(cc);
+  int lo = 0, hi = st->locCount;
+  if (!st->locSorted)
+  { qsort(st->byLoc,st->locCount,sizeof(LocRef),byLocation);
+    st->locSorted = TRUE;
+  }
+  /* find the first reference after at */
+  while (lo < hi)
+  { int mid = lo + (hi - lo) / 2;
+    if (st->byLoc[mid].loc <= at) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0 || locFile(st->byLoc[lo-1].loc) != locFile(at)) return NULL;
+  return st_symbol(cc,st->byLoc[lo-1].sym);
+}
+
+/* Function st_symbol returns the symbol numbered id,
+ * or NULL if there is none
+ */
+Symbol * st_symbol( Compiler * cc, int id )
+{ struct symTable * st = symtabOf(cc);
+  if (id < st->idBase)
+    return id >= 0 ? st->outer->syms[id] : NULL;
+  return id < st->idBase + st->symCount ? st->syms[id - st->idBase] : NULL;
+}
+
+/* Function st_count returns the number of symbols
+ * declared, so far
+ */
+int st_count( Compiler * cc )
+{ struct symTable * st = symtabOf(cc);
+  return st->idBase + st->symCount;
 }
 
-/* the list of line numbers of the source 
- * code in which a variable is referenced
+/* Procedure st_shareGlobals lets the table of w,
+ * which must be empty, see the global symbols of the
+ * table of cc as its own global scope. The table of
+ * cc must not change until st_merge; references to
+ * those symbols are held back until then
  */
-typedef struct LineListRec
-   { int lineno;
-     struct LineListRec * next;
-   } * LineList;
+void st_shareGlobals( Compiler * w, Compiler * cc )
+{ struct symTable * st = symtabOf(w);
+  st->outer = symtabOf(cc);
+  st->idBase = st->visible = st_count(cc);
+}
 
-/* The record in the bucket lists for
- * each variable, including name, 
- * assigned memory location, and
- * the list of line numbers in which
- * it appears in the source code
+/* Procedure st_hideGlobals makes the table of w not
+ * see the shared global symbols numbered n and up
  */
-typedef struct BucketListRec
-   { char * name;
-     LineList lines;
-     int memloc ; /* memory location for variable */
-     struct BucketListRec * next;
-   } * BucketList;
+void st_hideGlobals( Compiler * w, int n )
+{ symtabOf(w)->visible = n;
+}
+
+/* declaredAt returns where s is declared, 0 for a
+   symbol with no declaration or a predeclared one */
+static SrcLoc declaredAt( const Symbol * s )
+{ return s->decl != NULL ? s->decl->loc : 0;
+}
 
-/* the hash table */
-static BucketList hashTable[SIZE];
+/* Procedure st_merge moves the symbols declared in
+ * the tables of w[0] to w[n-1], which share the
+ * global scope of that of cc, into the latter, and
+ * numbers them all in the order of their
+ * declarations in the source, as declaring them in
+ * that order would; then it records the references
+ * held back to the global ones, table by table in
+ * the order they were made. The symbols stay in the
+ * arenas of the w[k], which the caller hands over to
+ * cc (arenaAdopt)
+ */
+void st_merge( Compiler * cc, Compiler * const * w, int n )
+{ struct symTable * st = symtabOf(cc);
+  Symbol ** old = st->syms, ** syms, ** run;
+  int count = st->symCount, i, j, k, m;
+  for (k = 0; k < n; k++) count += symtabOf(w[k])->symCount;
+  syms = malloc(count * sizeof(Symbol *));
+  run = malloc(count * sizeof(Symbol *));
+  if (syms == NULL || run == NULL)
+  { fprintf(stderr,"Out of memory for %d symbols\n",count);
+    exit(1);
+  }
+  /* every table is in the order declared, so each
+     merges into the symbols so far like two sorted
+     runs */
+  memcpy(syms,old,st->symCount * sizeof(Symbol *));
+  m = st->symCount;
+  for (k = 0; k < n; k++)
+  { struct symTable * from = symtabOf(w[k]);
+    Symbol ** t;
+    for (i = j = 0; i + j < m + from->symCount; )
+      if (j == from->symCount
+          || (i < m && declaredAt(syms[i]) <= declaredAt(from->syms[j])))
+      { run[i+j] = syms[i];
+        i++;
+      }
+      else
+      { run[i+j] = from->syms[j];
+        j++;
+      }
+    m += from->symCount;
+    t = syms; syms = run; run = t;
+  }
+  free(run);
+  for (i = 0; i < count; i++) syms[i]->id = i;
+  /* the references indexed so far, then those of
+     each table, take the new ids */
+  for (i = 0; i < st->locCount; i++)
+    st->byLoc[i].sym = old[st->byLoc[i].sym]->id;
+  for (k = 0; k < n; k++)
+  { struct symTable * from = symtabOf(w[k]);
+    st->byLoc = growArray(st->byLoc,&st->locCap,
+                          st->locCount + from->locCount - 1,sizeof(LocRef));
+    for (i = 0; i < from->locCount; i++)
+    { LocRef r = from->byLoc[i];
+      r.sym = from->syms[r.sym - from->idBase]->id;
+      if (st->locCount > 0 && r.loc < st->byLoc[st->locCount-1].loc)
+        st->locSorted = FALSE;
+      st->byLoc[st->locCount++] = r;
+    }
+  }
+  free(old);
+  st->syms = syms;
+  st->symCount = st->symCap = count;
+  for (k = 0; k < n; k++)
+  { struct symTable * from = symtabOf(w[k]);
+    for (i = 0; i < from->heldCount; i++)
+      st_reference(cc,from->held[i].sym,from->held[i].loc);
+  }
+}
 
-/* Procedure st_insert inserts line numbers and
+/* Procedure st_insert inserts source locations and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
-void st_insert( char * name, int lineno, int loc )
-{ int h = hash(name);
-  BucketList l =  hashTable[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
-  if (l == NULL) /* variable not yet in table */
-  { l = (BucketList) malloc(sizeof(struct BucketListRec));
-    l->name = name;
-    l->lines = (LineList) malloc(sizeof(struct LineListRec));
-    l->lines->lineno = lineno;
-    l->memloc = loc;
-    l->lines->next = NULL;
-    l->next = hashTable[h];
-    hashTable[h] = l; }
-  else /* found in table, so just add line number */
-  { LineList t = l->lines;
-    while (t->next != NULL) t = t->next;
-    t->next = (LineList) malloc(sizeof(struct LineListRec));
-    t->next->lineno = lineno;
-    t->next->next = NULL;
-  }
+void st_insert( Compiler * cc, Atom name, SrcLoc at, int loc )
+{ Symbol * s = st_find(cc,name);
+  if (s == NULL) /* variable not yet in table */
+    s = st_declare(cc,name,VarK,Integer,-1,loc,NULL);
+  st_reference(cc,s,at);
 } /* st_insert */
 
 /* Function st_lookup returns the memory 
  * location of a variable or -1 if not found
  */
-int st_lookup ( char * name )
-{ int h = hash(name);
-  BucketList l =  hashTable[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
-  if (l == NULL) return -1;
-  else return l->memloc;
+int st_lookup ( Compiler * cc, Atom name )
+{ Symbol * s = st_find(cc,name);
+  if (s == NULL) return -1;
+  else return s->offset;
 }
 
 /* Procedure printSymTab prints a formatted 
  * listing of the symbol table contents 
- * to the listing file
- */
-void printSymTab(FILE * listing)
-{ int i;
-  fprintf(listing,"Variable Name  Location   Line Numbers\n");
-  fprintf(listing,"-------------  --------   ------------\n");
-  for (i=0;i<SIZE;++i)
-  { if (hashTable[i] != NULL)
-    { BucketList l = hashTable[i];
-      while (l != NULL)
-      { LineList t = l->lines;
-        fprintf(listing,"%-14s ",l->name);
-        fprintf(listing,"%-8d  ",l->memloc);
-        while (t != NULL)
-        { fprintf(listing,"%4d ",t->lineno);
-          t = t->next;
-        }
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+ * to the listing file, a line for each
+ * declaration in the order they were made
+ */
+void printSymTab( Compiler * cc )
+{ struct symTable * st = symtabOf(cc);
+  Out * listing = cc->listing;
+  int i;
+  outStr(listing,"Variable Name  Location   Line Numbers\n");
+  outStr(listing,"-------------  --------   ------------\n");
+  for (i = 0; i < st->symCount; i++)
+  { Symbol * l = st->syms[i];
+    RefCursor c;
+    SrcLoc at;
+    outStrField(listing,l->name,-14);
+    outChar(listing,' ');
+    outInt(listing,l->offset,-8);
+    outStr(listing,"  ");
+    st_firstRef(l,&c);
+    while (st_nextRef(&c,&at))
+    { outInt(listing,locLine(cc,at),4);
+      outChar(listing,' ');
     }
+    outChar(listing,'\n');
   }
 } /* printSymTab */
+
+/* Procedure st_free releases the symbol table of cc;
+ * the symbols go with the arena
+ */
+void st_free( Compiler * cc )
+{ if (cc->symtab == NULL) return;
+  free(cc->symtab->slot);
+  free(cc->symtab->syms);
+  free(cc->symtab->held);
+  free(cc->symtab->byLoc);
+  free(cc->symtab->undo);
+  free(cc->symtab->scopeStart);
+  free(cc->symtab);
+  cc->symtab = NULL;
+}
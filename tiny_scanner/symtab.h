@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: symtab.h                                   */
 /* Symbol table interface for the TINY compiler     */
-/* (allows only one symbol table)                   */
+/* (one symbol table per compilation, cc->symtab)  */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -9,22 +9,160 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
-/* Procedure st_insert inserts line numbers and
+/* the references to a symbol are kept as the
+ * differences between their locations, each in as
+ * few bytes as it fits in, in blocks from the arena
+ * that double in size up to REFBLOCK bytes
+ */
+#define REFBLOCK 1024
+
+typedef struct refBlock
+   { struct refBlock * next;
+     int used, size;     /* bytes used, and room for */
+     unsigned char bytes[];
+   } RefBlock;
+
+/* A Symbol is one declaration of a name. Scopes nest:
+ * 0 is the global scope, and each st_enterScope opens
+ * one inside the current one. A declaration hides
+ * those of the same name in the scopes around it
+ * until its own scope is exited. Symbols live in the
+ * arena of the compilation
+ */
+typedef struct symbol
+   { Atom name;
+     DeclKind kind;     /* FuncK, VarK, ArrVarK, ParamK or ArrParamK */
+     ExpType type;      /* of the variable, or returned by the function */
+     int size;          /* elements of an array, -1 if not known */
+     int offset;        /* frame offset, location of a global, or
+                           code location of a generated function */
+     int scope;         /* depth of the scope it was declared in */
+     TreeNode * decl;   /* the declaration, or NULL */
+     int id;            /* its number, counting from 0 in the order declared */
+     int refCount;      /* the references to it */
+     SrcLoc lastRef;    /* where the last one is */
+     RefBlock * refs, * refTail; /* where they all are */
+     struct symbol * shadow; /* the declaration it hides, or NULL */
+   } Symbol;
+
+/* a position in the references to a symbol */
+typedef struct
+   { const RefBlock * block;
+     int pos;
+     SrcLoc loc;
+   } RefCursor;
+
+/* Procedure st_enterScope opens a scope inside the
+ * current one
+ */
+void st_enterScope( Compiler * cc );
+
+/* Procedure st_exitScope closes the current scope,
+ * so the names declared in it refer again to what
+ * they hid; its cost is the number of them
+ */
+void st_exitScope( Compiler * cc );
+
+/* Function st_depth returns the depth of the current
+ * scope, 0 for the global one
+ */
+int st_depth( Compiler * cc );
+
+/* Function st_declare declares name in the current
+ * scope and returns its symbol, or NULL if name is
+ * already declared in that scope
+ */
+Symbol * st_declare( Compiler * cc, Atom name, DeclKind kind,
+                     ExpType type, int size, int offset, TreeNode * decl );
+
+/* Function st_find returns the symbol name refers
+ * to in the current scope, or NULL if it is not
+ * declared
+ */
+Symbol * st_find( Compiler * cc, Atom name );
+
+/* Procedure st_reference records a reference to
+ * symbol s at location at
+ */
+void st_reference( Compiler * cc, Symbol * s, SrcLoc at );
+
+/* Procedure st_firstRef sets c before the first
+ * reference to s
+ */
+void st_firstRef( const Symbol * s, RefCursor * c );
+
+/* Function st_nextRef moves c to the next reference,
+ * in the order they were recorded, and returns TRUE
+ * with its location in *at, or FALSE if there are no
+ * more
+ */
+int st_nextRef( RefCursor * c, SrcLoc * at );
+
+/* Function st_symbolAt returns the symbol referenced
+ * at location at, or else the one referenced last
+ * before it in that file, or NULL if there is none
+ */
+Symbol * st_symbolAt( Compiler * cc, SrcLoc at );
+
+/* Function st_symbol returns the symbol numbered id,
+ * or NULL if there is none
+ */
+Symbol * st_symbol( Compiler * cc, int id );
+
+/* Function st_count returns the number of symbols
+ * declared, so far
+ */
+int st_count( Compiler * cc );
+
+/* A compilation can have its functions analyzed on
+ * several threads, each with a Compiler w of its own
+ * whose table shares the global scope of the main one
+ */
+
+/* Procedure st_shareGlobals lets the table of w,
+ * which must be empty, see the global symbols of the
+ * table of cc as its own global scope. The table of
+ * cc must not change until st_merge; references to
+ * those symbols are held back until then
+ */
+void st_shareGlobals( Compiler * w, Compiler * cc );
+
+/* Procedure st_hideGlobals makes the table of w not
+ * see the shared global symbols numbered n and up
+ */
+void st_hideGlobals( Compiler * w, int n );
+
+/* Procedure st_merge moves the symbols declared in
+ * the tables of w[0] to w[n-1], which share the
+ * global scope of that of cc, into the latter, and
+ * numbers them all in the order they are declared in
+ * the source; then it records the references held
+ * back to the global ones. The symbols stay in the
+ * arenas of the w[k], which the caller hands over
+ * to cc (arenaAdopt)
+ */
+void st_merge( Compiler * cc, Compiler * const * w, int n );
+
+/* Procedure st_insert inserts source locations and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
  * first time, otherwise ignored
  */
-void st_insert( char * name, int lineno, int loc );
+void st_insert( Compiler * cc, Atom name, SrcLoc at, int loc );
 
 /* Function st_lookup returns the memory 
  * location of a variable or -1 if not found
  */
-int st_lookup ( char * name );
+int st_lookup ( Compiler * cc, Atom name );
 
 /* Procedure printSymTab prints a formatted 
  * listing of the symbol table contents 
- * to the listing file
+ * to the listing file, with the line of
+ * every reference
  */
-void printSymTab(FILE * listing);
+void printSymTab( Compiler * cc );
+
+/* Procedure st_free releases the symbol table of cc */
+void st_free( Compiler * cc );
 
 #endif
@@ -0,0 +1,135 @@
+/****************************************************/
+/* File: tokbuf.c                                   */
+/* Token buffer between the scanner and the parser  */
+/****************************************************/
+
+#include "globals.h"
+#include "scan.h"
+#include "tokbuf.h"
+#include "intern.h"
+#include "arena.h"
+#include "srcloc.h"
+
+#include <limits.h>
+
+/* growBuffer makes room for at least need tokens */
+static void growBuffer( Compiler * cc, int need )
+{ int cap = cc->tokCap ? cc->tokCap : 1024;
+  while (cap < need) cap *= 2;
+  cc->tokKind = realloc(cc->tokKind,cap * sizeof(short));
+  cc->tokOff = realloc(cc->tokOff,cap * sizeof(int));
+  cc->tokLen = realloc(cc->tokLen,cap * sizeof(int));
+  if (!cc->tokKind || !cc->tokOff || !cc->tokLen)
+  { fprintf(stderr,"Out of memory for %d tokens\n",cap);
+    exit(1);
+  }
+  cc->tokCap = cap;
+}
+
+/* Function tokAppend adds a token to the buffer
+ * and returns its index
+ */
+int tokAppend( Compiler * cc, TokenType kind, int offset, int length )
+{ int i = cc->tokCount;
+  if (i == cc->tokCap) growBuffer(cc,i+1);
+  cc->tokKind[i] = (short) kind;
+  cc->tokOff[i] = offset;
+  cc->tokLen[i] = length;
+  cc->tokCount++;
+  return i;
+}
+
+/* Procedure tokReserve makes room for at least
+ * need tokens in all
+ */
+void tokReserve( Compiler * cc, int need )
+{ if (need > cc->tokCap) growBuffer(cc,need);
+}
+
+/* Function scanAll scans the whole source into the
+ * buffer, up to and including ENDFILE, and returns
+ * the number of tokens
+ */
+int scanAll( Compiler * cc )
+{ TokenType token;
+  /* C- averages well over four bytes a token */
+  tokReserve(cc,cc->srcLen / 4 + 1);
+  do
+  { token = getToken(cc);
+    if (token != C_COMMENT)
+      tokAppend(cc,token,cc->tokenOffset,cc->tokenLength);
+  } while (token != ENDFILE);
+  return cc->tokCount;
+}
+
+/* Function tokLoc returns the location of token i */
+SrcLoc tokLoc( Compiler * cc, int i )
+{ return makeLoc(cc->srcFile,cc->tokOff[i]);
+}
+
+/* Function tokenCopy allocates a copy of the
+ * lexeme of token i in the arena
+ */
+char * tokenCopy( Compiler * cc, int i )
+{ char * t = arenaAlloc(cc,cc->tokLen[i]+1);
+  if (t==NULL)
+    outPrintf(cc->listing,"Out of memory error at line %d\n",
+              locLine(cc,tokLoc(cc,i)));
+  else
+  { memcpy(t,cc->srcBuf+cc->tokOff[i],cc->tokLen[i]);
+    t[cc->tokLen[i]] = '\0';
+  }
+  return t;
+}
+
+/* Function tokenAtom returns the interned lexeme
+ * of token i
+ */
+Atom tokenAtom( Compiler * cc, int i )
+{ return intern(cc,cc->srcBuf+cc->tokOff[i],cc->tokLen[i]);
+}
+
+/* Function tokenValue returns the value of NUM
+ * token i, read in place; a number too large for an
+ * int is reported as a syntax error and read as
+ * INT_MAX
+ */
+int tokenValue( Compiler * cc, int i )
+{ const char * s = cc->srcBuf + cc->tokOff[i];
+  int n, val = 0;
+  for (n = 0; n < cc->tokLen[i]; n++)
+  { int d = s[n]-'0';
+    if (val > (INT_MAX - d) / 10)
+    { outPrintf(cc->listing,"Syntax error at line %d: %s is too large\n",
+                locLine(cc,tokLoc(cc,i)),tokenText(cc,i));
+      cc->Error = TRUE;
+      return INT_MAX;
+    }
+    val = val*10 + d;
+  }
+  return val;
+}
+
+/* Function tokenText fills tokenString with the
+ * (possibly truncated) lexeme of token i and returns
+ * it, for tracing and error messages
+ */
+char * tokenText( Compiler * cc, int i )
+{ int n = 0;
+  if (i >= 0 && i < cc->tokCount)
+  { n = cc->tokLen[i] < MAXTOKENLEN ? cc->tokLen[i] : MAXTOKENLEN;
+    memcpy(cc->tokenString,cc->srcBuf+cc->tokOff[i],n);
+  }
+  cc->tokenString[n] = '\0';
+  return cc->tokenString;
+}
+
+/* Procedure tokFree releases the buffer */
+void tokFree( Compiler * cc )
+{ free(cc->tokKind);
+  free(cc->tokOff);
+  free(cc->tokLen);
+  cc->tokKind = NULL;
+  cc->tokOff = cc->tokLen = NULL;
+  cc->tokCount = cc->tokCap = 0;
+}
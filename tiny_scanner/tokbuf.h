@@ -0,0 +1,63 @@
+/****************************************************/
+/* File: tokbuf.h                                   */
+/* Token buffer between the scanner and the parser  */
+/****************************************************/
+
+#ifndef _TOKBUF_H_
+#define _TOKBUF_H_
+
+/* The token buffer of cc holds every token scanned
+ * so far as parallel arrays indexed by token number:
+ * cc->tokKind (token type), cc->tokOff (lexeme offset
+ * in srcBuf) and cc->tokLen (lexeme length), with
+ * cc->tokCount tokens. The lexeme of token i is the
+ * slice srcBuf[tokOff[i] .. tokOff[i]+tokLen[i]); its
+ * line is found from the offset when needed (tokLoc)
+ */
+
+/* Function tokAppend adds a token to the buffer
+ * and returns its index
+ */
+int tokAppend( Compiler * cc, TokenType kind, int offset, int length );
+
+/* Procedure tokReserve makes room for at least
+ * need tokens in all
+ */
+void tokReserve( Compiler * cc, int need );
+
+/* Function scanAll scans the whole source into the
+ * buffer, up to and including ENDFILE, and returns
+ * the number of tokens
+ */
+int scanAll( Compiler * cc );
+
+/* Function tokLoc returns the location of token i */
+SrcLoc tokLoc( Compiler * cc, int i );
+
+/* Function tokenCopy allocates a copy of the
+ * lexeme of token i in the arena
+ */
+char * tokenCopy( Compiler * cc, int i );
+
+/* Function tokenAtom returns the interned lexeme
+ * of token i
+ */
+Atom tokenAtom( Compiler * cc, int i );
+
+/* Function tokenValue returns the value of NUM
+ * token i, read in place; a number too large for an
+ * int is reported as a syntax error and read as
+ * INT_MAX
+ */
+int tokenValue( Compiler * cc, int i );
+
+/* Function tokenText fills tokenString with the
+ * (possibly truncated) lexeme of token i and returns
+ * it, for tracing and error messages
+ */
+char * tokenText( Compiler * cc, int i );
+
+/* Procedure tokFree releases the buffer */
+void tokFree( Compiler * cc );
+
+#endif
@@ -8,95 +8,103 @@
 
 #include "globals.h"
 #include "util.h"
+#include "scan.h"
+#include "srcloc.h"
+#include "arena.h"
+#include "walk.h"
+
+/* Function tokenName returns the name printToken
+ * prints for a token, or NULL for one it does not
+ * know
+ */
+const char * tokenName( TokenType token )
+{ switch (token)
+  { case IF: return "IF";
+    case ELSE: return "ELSE";
+    case RETURN: return "RETURN";
+    case WHILE: return "WHILE";
+    case INT: return "INT";
+    case VOID: return "VOID";
+    case ASSIGN: return "ASSIGN";
+    case LT: return "LT";
+    case LTE: return "LTE";
+    case GT: return "GT";
+    case GTE: return "GTE";
+    case NEQ: return "NEQ";
+    case EQ: return "EQ";
+    case LPAREN: return "LPAREN";
+    case RPAREN: return "RPAREN";
+    case LSQUAREB: return "LSQUAREB";
+    case RSQUAREB: return "RSQUAREB";
+    case LCURLY: return "LCURLY";
+    case RCURLY: return "RCURLY";
+    case SEMICOLON: return "SEMICOLON";
+    case COMMA: return "COMMA";
+    case PLUS: return "PLUS";
+    case MINUS: return "MINUS";
+    case TIMES: return "TIMES";
+    case OVER: return "OVER";
+    case ENDFILE: return "EOF";
+    case NUM: return "NUM";
+    case ID: return "ID";
+    case ERROR: return "ERROR";
+    case COMMENT_ERROR: return "COMMENT_ERROR";
+    default: return NULL; /* should never happen */
+  }
+}
 
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
-void printToken( TokenType token, const char* tokenString )
-{ switch (token)
-  { case IF: fprintf(listing,"%-20s%-20s\n","IF",tokenString); break;
-    case ELSE: fprintf(listing,"%-20s%-20s\n","ELSE",tokenString); break;
-    case RETURN: fprintf(listing,"%-20s%-20s\n","RETURN",tokenString); break;
-    case WHILE: fprintf(listing,"%-20s%-20s\n","WHILE",tokenString); break;
-    case INT: fprintf(listing,"%-20s%-20s\n","INT",tokenString); break;
-    case VOID: fprintf(listing,"%-20s%-20s\n","VOID",tokenString); break;
-    case ASSIGN: fprintf(listing,"%-20s%-20s\n","ASSIGN",tokenString); break;
-    case LT: fprintf(listing,"%-20s%-20s\n","LT",tokenString); break;
-    case LTE: fprintf(listing,"%-20s%-20s\n","LTE",tokenString); break;
-    case GT: fprintf(listing,"%-20s%-20s\n","GT",tokenString); break;
-    case GTE: fprintf(listing,"%-20s%-20s\n","GTE",tokenString); break;
-    case NEQ: fprintf(listing,"%-20s%-20s\n","NEQ",tokenString); break;
-    case EQ: fprintf(listing,"%-20s%-20s\n","EQ",tokenString); break;
-    case LPAREN: fprintf(listing,"%-20s%-20s\n","LPAREN",tokenString); break;
-    case RPAREN: fprintf(listing,"%-20s%-20s\n","RPAREN",tokenString); break;
-    case LSQUAREB: fprintf(listing,"%-20s%-20s\n","LSQUAREB",tokenString); break;
-    case RSQUAREB: fprintf(listing,"%-20s%-20s\n","RSQUAREB",tokenString); break;
-    case LCURLY: fprintf(listing,"%-20s%-20s\n","LCURLY",tokenString); break;
-    case RCURLY: fprintf(listing,"%-20s%-20s\n","RCURLY",tokenString); break;
-    case SEMICOLON: fprintf(listing,"%-20s%-20s\n","SEMICOLON",tokenString); break;
-    case COMMA: fprintf(listing,"%-20s%-20s\n","COMMA",tokenString); break;
-    case PLUS: fprintf(listing,"%-20s%-20s\n","PLUS",tokenString); break;
-    case MINUS: fprintf(listing,"%-20s%-20s\n","MINUS",tokenString); break;
-    case TIMES: fprintf(listing,"%-20s%-20s\n","TIMES",tokenString); break;
-    case OVER: fprintf(listing,"%-20s%-20s\n","OVER",tokenString); break;
-    case ENDFILE: fprintf(listing,"%-20s%-20s\n","EOF",tokenString); break;
-    case NUM:
-      fprintf(listing,
-          "%-20s%-20s\n","NUM",tokenString);
-      break;
-    case ID:
-      fprintf(listing,
-          "%-20s%-20s\n","ID",tokenString);
-      break;
-    case ERROR:
-      fprintf(listing,
-          "%-20s%-20s\n","ERROR",tokenString);
-      break;
-    case COMMENT_ERROR:
-      fprintf(listing,
-          "%-20s%-20s\n","COMMENT_ERROR",tokenString);
-      break;
-    default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+void printToken( Compiler * cc, TokenType token, const char* tokenString )
+{ const char * name = tokenName(token);
+  if (name == NULL)
+  { outStr(cc->listing,"Unknown token: ");
+    outInt(cc->listing,token,0);
+    outChar(cc->listing,'\n');
+    return;
   }
+  outStrField(cc->listing,name,-20);
+  outStrField(cc->listing,tokenString,-20);
+  outChar(cc->listing,'\n');
 }
 
-void printOpToken(TokenType token)
+void printOpToken( Compiler * cc, TokenType token )
 {
   switch (token)
     {
     case LTE:
-      fprintf(listing,"<=\n");
+      outStr(cc->listing,"<=\n");
       break;
     case LT:
-      fprintf(listing,"<\n");
+      outStr(cc->listing,"<\n");
       break;
     case GTE:
-      fprintf(listing,">=\n");
+      outStr(cc->listing,">=\n");
       break;
     case GT:
-      fprintf(listing,">\n");
+      outStr(cc->listing,">\n");
       break;
     case EQ:
-      fprintf(listing,"==\n");
+      outStr(cc->listing,"==\n");
       break;
     case NEQ:
-      fprintf(listing,"!=\n");
+      outStr(cc->listing,"!=\n");
       break;
     case PLUS:
-      fprintf(listing,"+\n");
+      outStr(cc->listing,"+\n");
       break;
     case MINUS:
-      fprintf(listing,"-\n");
+      outStr(cc->listing,"-\n");
       break;
     case TIMES:
-      fprintf(listing,"*\n");
+      outStr(cc->listing,"*\n");
       break;
     case OVER:
-      fprintf(listing,"/\n");
+      outStr(cc->listing,"/\n");
       break;
     default:
-      fprintf(listing,"Not assigned OP token\n");
+      outStr(cc->listing,"Not assigned OP token\n");
       break;
     }
 }
@@ -104,17 +112,18 @@ void printOpToken(TokenType token)
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newStmtNode(Compiler * cc, StmtKind kind, SrcLoc loc)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    outPrintf(cc->listing,"Out of memory error at line %d\n",locLine(cc,loc));
   else {
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = StmtK;
     t->kind.stmt = kind;
-    t->lineno = lineno;
+    t->loc = loc;
+    t->sym = NULL;
   }
   return t;
 }
@@ -122,206 +131,226 @@ TreeNode * newStmtNode(StmtKind kind)
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+TreeNode * newExpNode(Compiler * cc, ExpKind kind, SrcLoc loc)
+{ TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    outPrintf(cc->listing,"Out of memory error at line %d\n",locLine(cc,loc));
   else {
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = ExpK;
     t->kind.exp = kind;
-    t->lineno = lineno;
+    t->loc = loc;
+    t->sym = NULL;
     t->type = Void;
   }
   return t;
 }
 
-TreeNode * newDeclNode(DeclKind kind)
+TreeNode * newDeclNode(Compiler * cc, DeclKind kind, SrcLoc loc)
 {
-  TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+  TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing, "Out of memory error at line %d\n",lineno);
+    outPrintf(cc->listing,"Out of memory error at line %d\n",locLine(cc,loc));
   else
     {
       for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
       t->sibling = NULL;
       t->nodekind = DeclK;
       t->kind.decl = kind;
-      t->lineno = lineno;
+      t->loc = loc;
+      t->sym = NULL;
     }
   return t;
 }
 
-TreeNode * newTypeNode(TypeKind kind)
+TreeNode * newTypeNode(Compiler * cc, TypeKind kind, SrcLoc loc)
 {
-  TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+  TreeNode * t = (TreeNode *) arenaAlloc(cc,sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing, "Out of memory error at line %d\n",lineno);
+    outPrintf(cc->listing,"Out of memory error at line %d\n",locLine(cc,loc));
   else
     {
       for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
       t->sibling = NULL;
       t->nodekind = TypeK;
       t->kind.type = kind;
-      t->lineno = lineno;
+      t->loc = loc;
+      t->sym = NULL;
     }
   return t;
 }
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
  */
-char * copyString(char * s)
+char * copyString(Compiler * cc, char * s)
 { int n;
   char * t;
   if (s==NULL) return NULL;
   n = strlen(s)+1;
-  t = malloc(n);
+  t = arenaAlloc(cc,n);
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    outStr(cc->listing,"Out of memory error\n");
   else strcpy(t,s);
   return t;
 }
 
-/* Variable indentno is used by printTree to
- * store current number of spaces to indent
+/* Function lexemeString fills tokenString with the
+ * (possibly truncated) lexeme of the current token
+ * and returns it, for tracing and error messages
  */
-static indentno = 0;
+char * lexemeString( Compiler * cc )
+{ int n = cc->tokenLength < MAXTOKENLEN ? cc->tokenLength : MAXTOKENLEN;
+  memcpy(cc->tokenString,cc->srcBuf+cc->tokenOffset,n);
+  cc->tokenString[n] = '\0';
+  return cc->tokenString;
+}
 
-/* macros to increase/decrease indentation */
-#define INDENT indentno+=2
-#define UNINDENT indentno-=2
+/* printSpaces indents by two spaces for each level
+ * the node being printed is at
+ */
+static void printSpaces( Compiler * cc )
+{ outSpaces(cc->listing,2*walkDepth(cc));
+}
 
-/* printSpaces indents by printing spaces */
-static void printSpaces(void)
-{ int i;
-  for (i=0;i<indentno;i++)
-    fprintf(listing," ");
+/* printName prints label and then name on a line of
+ * its own
+ */
+static void printName( Compiler * cc, const char * label, const char * name )
+{ outStr(cc->listing,label);
+  outStr(cc->listing,name);
+  outChar(cc->listing,'\n');
 }
 
-/* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
+/* printNode prints a syntax tree node, indented as
+ * deep as it is in the tree
  */
-void printTree( TreeNode * tree )
-{ int i;
-  INDENT;
-  while (tree != NULL) {
-    printSpaces();
-    if (tree->nodekind==StmtK)
-    { switch (tree->kind.stmt) {
-        case IfK:
-          fprintf(listing,"If\n");
-          break;
-        case LoopK:
-          fprintf(listing,"While\n");
-          break;
-        case RetK:
-          fprintf(listing,"Return\n");
-          break;
-        case CompK:
-          fprintf(listing,"Compound Statement\n");
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
-    }
-    else if (tree->nodekind==ExpK)
-    { switch (tree->kind.exp) {
-        case OpK:
-          switch(tree->attr.op) {
-            case PLUS:
-            case MINUS:
-              fprintf(listing,"Additive Expression\n");
-              printSpaces();
-              break;
-            case TIMES:
-            case OVER:
-              fprintf(listing,"Multiplicative Expression\n");
-              printSpaces();
-              break;
-            default:
-              fprintf(listing,"Simple Expression\n");
-              printSpaces();
-              break;
-          }
-          fprintf(listing,"  Operator : ");
-          printOpToken(tree->attr.op);
-          break;
-        case ConstK:
-          fprintf(listing,"Constant : %d\n",tree->attr.val);
-          break;
-        case IdK:
-          fprintf(listing,"Variable : %s\n",tree->attr.name);
-          break;
-        case ArrIdK:
-          fprintf(listing,"Array ID : %s\n",tree->attr.name);
-          break;
-        case CallK:
-          fprintf(listing,"Call to %s\n",tree->attr.name);
-          break;
-        case AssignK:
-          fprintf(listing,"Assign : =\n");
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
+static void printNode( Compiler * cc, TreeNode * tree )
+{ printSpaces(cc);
+  if (tree->nodekind==StmtK)
+  { switch (tree->kind.stmt) {
+      case IfK:
+        outStr(cc->listing,"If\n");
+        break;
+      case LoopK:
+        outStr(cc->listing,"While\n");
+        break;
+      case RetK:
+        outStr(cc->listing,"Return\n");
+        break;
+      case CompK:
+        outStr(cc->listing,"Compound Statement\n");
+        break;
+      default:
+        outStr(cc->listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else if (tree->nodekind==DeclK)
-    { switch (tree->kind.decl){
-        case FuncK:
-          fprintf(listing,"Function Declare : %s\n",tree->attr.name);
-          break;
-        case VarK:
-          fprintf(listing,"Variable Declare : %s\n",tree->attr.name);
-          break;
-        case ArrVarK:
-          if(tree->attr.arrAttr.size < 0)
-            fprintf(listing,"Array Variable Declare : %s\n",tree->attr.arrAttr.name);
-          else
-            fprintf(listing,"Array Variable Allocate : %s of size %d\n",tree->attr.arrAttr.name,tree->attr.arrAttr.size);
-          break;
-        case ParamK:
-          fprintf(listing,"Param : %s\n",tree->attr.name);
-          break;
-        case ArrParamK:
-          fprintf(listing,"Array Param : %s\n",tree->attr.name);
-          break;
-        default:
-          fprintf(listing,"Unknown Declaration Node Kind\n");
-          break;
-      }
+  }
+  else if (tree->nodekind==ExpK)
+  { switch (tree->kind.exp) {
+      case OpK:
+        switch(tree->attr.op) {
+          case PLUS:
+          case MINUS:
+            outStr(cc->listing,"Additive Expression\n");
+            printSpaces(cc);
+            break;
+          case TIMES:
+          case OVER:
+            outStr(cc->listing,"Multiplicative Expression\n");
+            printSpaces(cc);
+            break;
+          default:
+            outStr(cc->listing,"Simple Expression\n");
+            printSpaces(cc);
+            break;
+        }
+        outStr(cc->listing,"  Operator : ");
+        printOpToken(cc,tree->attr.op);
+        break;
+      case ConstK:
+        outStr(cc->listing,"Constant : ");
+        outInt(cc->listing,tree->attr.val,0);
+        outChar(cc->listing,'\n');
+        break;
+      case IdK:
+        printName(cc,"Variable : ",tree->attr.name);
+        break;
+      case ArrIdK:
+        printName(cc,"Array ID : ",tree->attr.name);
+        break;
+      case CallK:
+        printName(cc,"Call to ",tree->attr.name);
+        break;
+      case AssignK:
+        outStr(cc->listing,"Assign : =\n");
+        break;
+      default:
+        outStr(cc->listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else if (tree->nodekind==TypeK)
-    { switch (tree->kind.type){
-        case TypeNameK:
-          fprintf(listing,"Type : ");
-          switch (tree->attr.type){
-            case INT:
-              fprintf(listing,"int\n");
-              break;
-            case VOID:
-              fprintf(listing,"void\n");
-              break;
-            default:
-              fprintf(listing,"Unknown Variable Type\n");
-              break;
+  }
+  else if (tree->nodekind==DeclK)
+  { switch (tree->kind.decl){
+      case FuncK:
+        printName(cc,"Function Declare : ",tree->attr.name);
+        break;
+      case VarK:
+        printName(cc,"Variable Declare : ",tree->attr.name);
+        break;
+      case ArrVarK:
+        if(tree->attr.arrAttr.size < 0)
+          printName(cc,"Array Variable Declare : ",tree->attr.arrAttr.name);
+        else
+          { outStr(cc->listing,"Array Variable Allocate : ");
+            outStr(cc->listing,tree->attr.arrAttr.name);
+            outStr(cc->listing," of size ");
+            outInt(cc->listing,tree->attr.arrAttr.size,0);
+            outChar(cc->listing,'\n');
           }
-          break;
-        default:
-          fprintf(listing,"Unknown Type Node Kind\n");
-          break;
-      }
+        break;
+      case ParamK:
+        printName(cc,"Param : ",tree->attr.name);
+        break;
+      case ArrParamK:
+        printName(cc,"Array Param : ",tree->attr.name);
+        break;
+      default:
+        outStr(cc->listing,"Unknown Declaration Node Kind\n");
+        break;
     }
-    else fprintf(listing,"Unknown node kind\n");
-    for (i=0;i<MAXCHILDREN;i++)
-         printTree(tree->child[i]);
-    tree = tree->sibling;
   }
-  UNINDENT;
+  else if (tree->nodekind==TypeK)
+  { switch (tree->kind.type){
+      case TypeNameK:
+        outStr(cc->listing,"Type : ");
+        switch (tree->attr.type){
+          case INT:
+            outStr(cc->listing,"int\n");
+            break;
+          case VOID:
+            outStr(cc->listing,"void\n");
+            break;
+          default:
+            outStr(cc->listing,"Unknown Variable Type\n");
+            break;
+        }
+        break;
+      default:
+        outStr(cc->listing,"Unknown Type Node Kind\n");
+        break;
+    }
+  }
+  else outStr(cc->listing,"Unknown node kind\n");
+}
+
+/* procedure printTree prints a syntax tree to the 
+ * listing file using indentation to indicate subtrees
+ */
+void printTree( Compiler * cc, TreeNode * tree )
+{ walkTree(cc,tree,printNode,NULL,NULL);
 }
@@ -8,34 +8,46 @@
 #ifndef _UTIL_H_
 #define _UTIL_H_
 
+/* Function tokenName returns the name printToken
+ * prints for a token, or NULL for one it does not
+ * know
+ */
+const char * tokenName( TokenType );
+
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
-void printToken( TokenType, const char* );
-void printOpToken(TokenType);
+void printToken( Compiler *, TokenType, const char* );
+void printOpToken( Compiler *, TokenType );
 
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind);
+TreeNode * newStmtNode(Compiler *, StmtKind, SrcLoc);
 
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind);
+TreeNode * newExpNode(Compiler *, ExpKind, SrcLoc);
 
-TreeNode * newDeclNode(DeclKind);
+TreeNode * newDeclNode(Compiler *, DeclKind, SrcLoc);
 
-TreeNode * newTypeNode(TypeKind);
+TreeNode * newTypeNode(Compiler *, TypeKind, SrcLoc);
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
+ */
+char * copyString( Compiler *, char * );
+
+/* Function lexemeString fills tokenString with the
+ * (possibly truncated) lexeme of the current token
+ * and returns it, for tracing and error messages
  */
-char * copyString( char * );
+char * lexemeString( Compiler * );
 
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
-void printTree( TreeNode * );
+void printTree( Compiler *, TreeNode * );
 
 #endif
@@ -0,0 +1,159 @@
+/****************************************************/
+/* File: walk.c                                     */
+/* Syntax tree walks on an explicit stack, so that  */
+/* no tree is too deep or too long to walk          */
+/* The stack belongs to the Compiler and is kept    */
+/* from one walk, and one compilation, to the next; */
+/* it grows with the depth of the tree, never with  */
+/* the length of a sibling chain                    */
+/****************************************************/
+
+#include "globals.h"
+#include "walk.h"
+
+/* walkOf returns the stack of cc, allocating it on
+   first use */
+static struct walk * walkOf( Compiler * cc )
+{ if (cc->walk == NULL && (cc->walk = calloc(1,sizeof(struct walk))) == NULL)
+  { fprintf(stderr,"Out of memory for the walk stack\n");
+    exit(1);
+  }
+  return cc->walk;
+}
+
+/* Function walkBegin starts a walk, returning what
+ * walkEnd needs to end it
+ */
+int walkBegin( Compiler * cc )
+{ struct walk * w = walkOf(cc);
+  int saved = w->base;
+  w->base = w->depth;
+  return saved;
+}
+
+/* Procedure walkEnd ends the walk walkBegin started */
+void walkEnd( Compiler * cc, int saved )
+{ struct walk * w = cc->walk;
+  w->depth = w->base;
+  w->base = saved;
+}
+
+/* Function walkPush pushes a frame and returns it;
+ * the pointer is good until the next push
+ */
+WalkFrame * walkPush( Compiler * cc )
+{ struct walk * w = cc->walk;
+  WalkFrame * fr;
+  if (w->depth == w->cap)
+  { int cap = w->cap ? 2 * w->cap : 256;
+    WalkFrame * s = realloc(w->stack,cap * sizeof(WalkFrame));
+    if (s == NULL)
+    { fprintf(stderr,"Out of memory for a tree %d deep\n",w->depth);
+      exit(1);
+    }
+    w->stack = s;
+    w->cap = cap;
+  }
+  fr = &w->stack[w->depth++];
+  fr->n = -1;
+  fr->i = -1;
+  return fr;
+}
+
+/* Procedure walkPop pops a frame */
+void walkPop( Compiler * cc )
+{ cc->walk->depth--;
+}
+
+/* Function walkDepth returns the depth of the node
+ * being visited in the innermost walk: 1 for the
+ * node the walk started at and its siblings
+ */
+int walkDepth( Compiler * cc )
+{ return cc->walk->depth - cc->walk->base;
+}
+
+/* Function walkFrame returns the frame of the node
+ * being visited (up = 0) or of its ancestor up
+ * levels above it, or NULL if there is none in the
+ * innermost walk
+ */
+WalkFrame * walkFrame( Compiler * cc, int up )
+{ struct walk * w = cc->walk;
+  return w->depth - 1 - up >= w->base ? &w->stack[w->depth - 1 - up] : NULL;
+}
+
+/* Procedure walkSkip, called from preProc, makes
+ * walkTree leave out the children of the node;
+ * postProc is still applied to it
+ */
+void walkSkip( Compiler * cc )
+{ cc->walk->stack[cc->walk->depth - 1].i = MAXCHILDREN;
+}
+
+/* Procedure walkTree applies preProc in preorder and
+ * postProc in postorder to t, its siblings and all
+ * their descendants, in the order a recursive walk
+ * over child[0..MAXCHILDREN-1] and then sibling
+ * would. inProc, unless NULL, is applied to a node
+ * with i before its child list i is walked, whether
+ * or not it is empty; preProc and postProc may be
+ * NULL as well. A hook may start another walk of
+ * its own with the same cc
+ */
+void walkTree( Compiler * cc, TreeNode * t, WalkProc preProc,
+               WalkInProc inProc, WalkProc postProc )
+{ struct walk * w;
+  int saved;
+  if (t == NULL) return;
+  saved = walkBegin(cc);
+  w = cc->walk;
+  walkPush(cc)->t = t;
+  while (w->depth > w->base)
+  { /* the stack may move when a hook walks or a
+       child is pushed, so the frame is found again */
+    WalkFrame * fr = &w->stack[w->depth - 1];
+    if (fr->i < 0)
+    { fr->i = 0;
+      if (preProc != NULL) preProc(cc,fr->t);
+      fr = &w->stack[w->depth - 1];
+    }
+    if (inProc == NULL)
+    { /* go straight to the next child there is */
+      while (fr->i < MAXCHILDREN)
+      { TreeNode * c = fr->t->child[fr->i++];
+        if (c != NULL)
+        { walkPush(cc)->t = c;
+          break;
+        }
+      }
+      if (&w->stack[w->depth - 1] != fr) continue;
+    }
+    else if (fr->i < MAXCHILDREN)
+    { TreeNode * c;
+      int i = fr->i++;
+      inProc(cc,fr->t,i);
+      fr = &w->stack[w->depth - 1];
+      if ((c = fr->t->child[i]) != NULL) walkPush(cc)->t = c;
+      continue;
+    }
+    if (postProc != NULL)
+    { postProc(cc,fr->t);
+      fr = &w->stack[w->depth - 1];
+    }
+    if (fr->t->sibling != NULL)
+    { fr->t = fr->t->sibling;
+      fr->i = -1;
+    }
+    else w->depth--;
+  }
+  walkEnd(cc,saved);
+}
+
+/* Procedure walkFree releases the walk stack of cc */
+void walkFree( Compiler * cc )
+{ if (cc->walk == NULL) return;
+  free(cc->walk->stack);
+  free(cc->walk);
+  cc->walk = NULL;
+}
@@ -0,0 +1,90 @@
+/****************************************************/
+/* File: walk.h                                     */
+/* Syntax tree walks on an explicit stack, so that  */
+/* no tree is too deep or too long to walk          */
+/****************************************************/
+
+#ifndef _WALK_H_
+#define _WALK_H_
+
+/* WALK_LOCALS is the number of ints a frame keeps
+ * for the pass that walks the tree
+ */
+#define WALK_LOCALS 2
+
+/* A frame of the walk stack stands for a node being
+ * walked: the frames below it are its ancestors.
+ * Once a node is done the frame is reused for its
+ * next sibling, so a chain of siblings takes one
+ * frame however long it is
+ */
+typedef struct
+   { TreeNode * t;       /* the node */
+     int n;              /* free for the pass; -1 when pushed */
+     int i;              /* next child list to walk, -1 before preProc */
+     int local[WALK_LOCALS]; /* free for the pass, for what a
+                                recursive pass keeps in locals */
+   } WalkFrame;
+
+/* the walk stack of a compilation, cc->walk; the
+ * frames of the innermost walk are those from base
+ * up to depth
+ */
+struct walk
+   { WalkFrame * stack;
+     int depth, cap;
+     int base;
+   };
+
+/* the hooks of walkTree */
+typedef void (* WalkProc) (Compiler * cc, TreeNode * t);
+typedef void (* WalkInProc) (Compiler * cc, TreeNode * t, int i);
+
+/* Procedure walkTree applies preProc in preorder and
+ * postProc in postorder to t, its siblings and all
+ * their descendants, in the order a recursive walk
+ * over child[0..MAXCHILDREN-1] and then sibling
+ * would. inProc, unless NULL, is applied to a node
+ * with i before its child list i is walked, whether
+ * or not it is empty; preProc and postProc may be
+ * NULL as well. A hook may start another walk of
+ * its own with the same cc
+ */
+void walkTree( Compiler * cc, TreeNode * t, WalkProc preProc,
+               WalkInProc inProc, WalkProc postProc );
+
+/* Procedure walkSkip, called from preProc, makes
+ * walkTree leave out the children of the node;
+ * postProc is still applied to it
+ */
+void walkSkip( Compiler * cc );
+
+/* Function walkDepth returns the depth of the node
+ * being visited in the innermost walk: 1 for the
+ * node the walk started at and its siblings
+ */
+int walkDepth( Compiler * cc );
+
+/* Function walkFrame returns the frame of the node
+ * being visited (up = 0) or of its ancestor up
+ * levels above it, or NULL if there is none in the
+ * innermost walk
+ */
+WalkFrame * walkFrame( Compiler * cc, int up );
+
+/* Walks of other trees (flat.h) drive the stack
+ * themselves: walkBegin starts a walk, returning what
+ * walkEnd needs to end it, walkPush pushes a frame
+ * (its pointer is good until the next push) and
+ * walkPop pops one. In between they may use the
+ * frames of cc->walk directly
+ */
+int walkBegin( Compiler * cc );
+WalkFrame * walkPush( Compiler * cc );
+void walkPop( Compiler * cc );
+void walkEnd( Compiler * cc, int saved );
+
+/* Procedure walkFree releases the walk stack of cc */
+void walkFree( Compiler * cc );
+
+#endif
@@ -11,43 +11,94 @@
 #include "util.h"
 #include "scan.h"
 #include "parse.h"
+#include "tokbuf.h"
+#include "plex.h"
+#include "srcloc.h"
+#include "rdparse.h"
+
+/* The parser is pure: all its state, including
+ * savedName and savedTree, is in the Compiler cc
+ * passed to yyparse and on to yylex and yyerror
+ */
 
-#define YYSTYPE TreeNode *
-static char * savedName; /* for use in assignments */
-static int savedLineNo;  /* ditto */
-static TreeNode * savedTree; /* stores syntax tree for later return */
-
-static int yyerror(char * message);
-static int yylex(void);
+/* new nodes are placed at the lookahead token */
+#define LOC tokLoc(cc,cc->curTok)
 %}
 
+/* tokens carry their index in the token buffer;
+   nonterminals carry syntax trees, and the lists
+   carry their last node as well so that appending
+   to them takes constant time */
+%union { struct treeNode * node; NodeList list; int tok; }
+
+%code requires {
+struct compiler;
+struct treeNode;
+
+/* a sibling chain under construction */
+typedef struct nodeList
+   { struct treeNode * head;
+     struct treeNode * tail;   /* last node of the chain */
+   } NodeList;
+}
+
+%code {
+static int yyerror( Compiler * cc, const char * message );
+static int yylex( YYSTYPE * lvalp, Compiler * cc );
+
+/* listAppend appends the sibling chain t, which may
+ * be empty, to the list l in time proportional to the
+ * length of t alone, so a list of n nodes is built in
+ * O(n) rather than by walking it from the head on
+ * every reduction
+ */
+static void listAppend( NodeList * l, TreeNode * t )
+{ if (t == NULL) return;
+  if (l->head == NULL) l->head = t;
+  else l->tail->sibling = t;
+  while (t->sibling != NULL) t = t->sibling;
+  l->tail = t;
+}
+}
+
+%define api.pure full
+%parse-param { struct compiler * cc }
+%lex-param { struct compiler * cc }
+
 %token IF ELSE RETURN WHILE
 %token INT VOID
-%token ID NUM
+%token <tok> ID NUM
 %token ASSIGN EQ NEQ LT LTE GT GTE PLUS MINUS TIMES OVER
 %token LPAREN LSQUAREB LCURLY RPAREN RSQUAREB RCURLY SEMICOLON COMMA
 %token ERROR C_COMMENT COMMENT_ERROR ENDFILE
 
 %right RPAREN ELSE
 
+%type <node> declaration var-declaration type-specifier
+%type <node> fun-declaration params param compound-stmt
+%type <node> statement expression-stmt
+%type <node> selection-stmt iteration-stmt return-stmt expression var
+%type <node> simple-expression relop additive-expression addop term mulop
+%type <node> factor call args empty
+%type <list> declaration-list param-list local-declarations
+%type <list> statement-list arg-list
+
 %start program
 
 %% /* Grammar for C- lang */
 
 program     : declaration-list
-                 { savedTree = $1;} 
+                 { cc->savedTree = $1.head;} 
             ;
 
 declaration-list    : declaration-list declaration
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
+                 { $$ = $1;
+                   listAppend(&$$,$2);
+                 }
+            | declaration
+                 { $$.head = $$.tail = NULL;
+                   listAppend(&$$,$1);
                  }
-            | declaration { $$ = $1; }
             ;
 
 declaration : var-declaration { $$ = $1; }
@@ -55,103 +106,91 @@ declaration : var-declaration { $$ = $1; }
             ;
 
 var-declaration : type-specifier identifier SEMICOLON
-                  { $$ = newDeclNode(VarK);
-                    $$->attr.name = savedName;
+                  { $$ = newDeclNode(cc,VarK,LOC);
+                    $$->attr.name = cc->savedName;
                     $$->child[0] = $1;
                   }
             | type-specifier identifier
-                  { $$ = newDeclNode(ArrVarK);
-                    $$->attr.arrAttr.name = savedName;
-                    $$->child[0] = $1;
+                  { $<node>$ = newDeclNode(cc,ArrVarK,LOC);
+                    $<node>$->attr.arrAttr.name = cc->savedName;
+                    $<node>$->child[0] = $1;
                   }
               LSQUAREB NUM 
-                  { $$ = $3;
-                    $$->attr.arrAttr.size = atoi(tokenString); 
+                  { $<node>$ = $<node>3;
+                    $<node>$->attr.arrAttr.size = tokenValue(cc,$5); 
                   }
               RSQUAREB SEMICOLON
-                  { $$ = $6; }
+                  { $$ = $<node>6; }
             ;
 
 type-specifier : INT
-                  { $$ = newTypeNode(TypeNameK);
+                  { $$ = newTypeNode(cc,TypeNameK,LOC);
                     $$->attr.type = INT;
                   }
             | VOID
-                  { $$ = newTypeNode(TypeNameK);
+                  { $$ = newTypeNode(cc,TypeNameK,LOC);
                     $$->attr.type = VOID;
                   } 
             ;
 
 fun-declaration : type-specifier identifier
-                  { $$ = newDeclNode(FuncK);
-                    $$->attr.name = savedName;
+                  { $<node>$ = newDeclNode(cc,FuncK,LOC);
+                    $<node>$->attr.name = cc->savedName;
                   }
                     LPAREN params RPAREN compound-stmt
-                  { $$ = $3;
+                  { $$ = $<node>3;
                     $$->child[0] = $1;
                     $$->child[1] = $5;
                     $$->child[2] = $7;
                   }
             ;
 
-params      : param-list { $$ = $1; }
+params      : param-list { $$ = $1.head; }
             | VOID { $$ = NULL; }
             ;
 
 param-list   : param-list COMMA param
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $3;
-                     $$ = $1; }
-                     else $$ = $3;
+                 { $$ = $1;
+                   listAppend(&$$,$3);
+                 }
+            | param
+                 { $$.head = $$.tail = NULL;
+                   listAppend(&$$,$1);
                  }
-            | param { $$ = $1; }
             ;
 
 param       : type-specifier identifier
-                  { $$ = newDeclNode(ParamK);
-                    $$->attr.name = savedName;
+                  { $$ = newDeclNode(cc,ParamK,LOC);
+                    $$->attr.name = cc->savedName;
                     $$->child[0] = $1;
                   }
             | type-specifier identifier LSQUAREB RSQUAREB
-                  { $$ = newDeclNode(ArrParamK);
-                    $$->attr.arrAttr.name = savedName;
+                  { $$ = newDeclNode(cc,ArrParamK,LOC);
+                    $$->attr.arrAttr.name = cc->savedName;
                     $$->attr.arrAttr.size = -1;
                     $$->child[0] = $1;
                   }
             ;
 
 compound-stmt : LCURLY local-declarations statement-list RCURLY
-                  { $$ = newStmtNode(CompK);
-                    $$->child[0] = $2;
-                    $$->child[1] = $3;
+                  { $$ = newStmtNode(cc,CompK,LOC);
+                    $$->child[0] = $2.head;
+                    $$->child[1] = $3.head;
                   }
             ;
 
 local-declarations : local-declarations var-declaration
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
+                 { $$ = $1;
+                   listAppend(&$$,$2);
                  }
-            | empty { $$ = $1; }
+            | empty { $$.head = $$.tail = NULL; }
             ;
 
 statement-list    : statement-list statement
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $2;
-                     $$ = $1; }
-                     else $$ = $2;
+                 { $$ = $1;
+                   listAppend(&$$,$2);
                  }
-            | empty { $$ = $1; }
+            | empty { $$.head = $$.tail = NULL; }
             ;
 
 statement   : expression-stmt { $$ = $1; }
@@ -167,34 +206,34 @@ expression-stmt : expression SEMICOLON
             ;
 
 selection-stmt     : IF LPAREN expression RPAREN statement
-                  { $$ = newStmtNode(IfK);
+                  { $$ = newStmtNode(cc,IfK,LOC);
                     $$->child[0] = $3;
                     $$->child[1] = $5;
                   }
             | IF LPAREN expression RPAREN statement ELSE statement
-                  { $$ = newStmtNode(IfK);
+                  { $$ = newStmtNode(cc,IfK,LOC);
                     $$->child[0] = $3;
                     $$->child[1] = $5;
                     $$->child[2] = $7;
                   }
             ;
 
-iteration-stmt : WHILE LPAREN expression RPAREN statement-list
-                 { $$ = newStmtNode(LoopK);
+iteration-stmt : WHILE LPAREN expression RPAREN statement
+                 { $$ = newStmtNode(cc,LoopK,LOC);
                    $$->child[0] = $3;
                    $$->child[1] = $5;
                  }
             ;
 
 return-stmt : RETURN SEMICOLON
-                { $$ = newStmtNode(RetK); }
+                { $$ = newStmtNode(cc,RetK,LOC); }
             | RETURN expression SEMICOLON
-                { $$ = newStmtNode(RetK);
+                { $$ = newStmtNode(cc,RetK,LOC);
                   $$->child[0] = $2;
                 }
 
 expression  : var ASSIGN expression
-                { $$ = newExpNode(AssignK);
+                { $$ = newExpNode(cc,AssignK,LOC);
                   $$->child[0] = $1;
                   $$->child[1] = $3;
                 }
@@ -202,21 +241,21 @@ expression  : var ASSIGN expression
             ;
 
 var    : identifier
-                { $$ = newExpNode(IdK);
-                  $$->attr.name = savedName;
+                { $$ = newExpNode(cc,IdK,LOC);
+                  $$->attr.name = cc->savedName;
                 }
             | identifier 
-                { $$ = newExpNode(ArrIdK);
-                  $$->attr.name = savedName;
+                { $<node>$ = newExpNode(cc,ArrIdK,LOC);
+                  $<node>$->attr.name = cc->savedName;
                 }
               LSQUAREB expression RSQUAREB
-                { $$ = $2;
+                { $$ = $<node>2;
                   $$->child[0] = $4; 
                 }
             ;
 
 identifier  : ID
-                  { savedName = copyString(tokenString); }
+                  { cc->savedName = tokenAtom(cc,$1); }
             ;
 
 simple-expression  : additive-expression relop additive-expression
@@ -228,28 +267,28 @@ simple-expression  : additive-expression relop additive-expression
             ;
 
 relop       : LTE
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = LTE;
                 }
             | LT
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = LT;
                 }
             | GT
                 {
-                  $$ = newExpNode(OpK);
+                  $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = GT;
                 }
             | GTE
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = GTE;
                 }
             | EQ
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = EQ;
                 }
             | NEQ
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = NEQ;
                 }
             ;
@@ -263,11 +302,11 @@ additive-expression : additive-expression addop term
                     ;
 
 addop       : PLUS
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = PLUS;
                 }
             | MINUS
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = MINUS;
                 }
             ;
@@ -281,12 +320,12 @@ term        : term mulop factor
             ;
 
 mulop       : TIMES
-                { $$ = newExpNode(OpK);
+                { $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = TIMES;
                 }
             | OVER
                 {
-                  $$ = newExpNode(OpK);
+                  $$ = newExpNode(cc,OpK,LOC);
                   $$->attr.op = OVER;
                 }
             ;
@@ -298,62 +337,78 @@ factor      : LPAREN expression RPAREN
             | call
                   { $$ = $1; }
             | NUM
-                  { $$ = newExpNode(ConstK);
-                    $$->attr.val = atoi(tokenString);
+                  { $$ = newExpNode(cc,ConstK,LOC);
+                    $$->attr.val = tokenValue(cc,$1);
                   }
             ;
 
 call        : identifier
-                { $$ = newExpNode(CallK);
-                  $$->attr.name = savedName;
+                { $<node>$ = newExpNode(cc,CallK,LOC);
+                  $<node>$->attr.name = cc->savedName;
                 }
               LPAREN args RPAREN
-                { $$ = $2;
+                { $$ = $<node>2;
                   $$->child[0] = $4;
                 }
             ;
 
-args        : arg-list { $$ = $1; }
+args        : arg-list { $$ = $1.head; }
             | empty { $$ = $1; }
             ;
 
 arg-list      : arg-list COMMA expression
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $3;
-                     $$ = $1; }
-                     else $$ = $3;
+                 { $$ = $1;
+                   listAppend(&$$,$3);
+                 }
+            | expression
+                 { $$.head = $$.tail = NULL;
+                   listAppend(&$$,$1);
                  }
-            | expression { $$ = $1; }
             ;
 
 empty       : { $$ = NULL; }
             ;
 %%
 
-int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
-  fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString);
-  Error = TRUE;
+/* yyerror reports a syntax error at the lookahead,
+ * the token last handed to the parser
+ */
+static int yyerror( Compiler * cc, const char * message )
+{ outPrintf(cc->listing,"Syntax error at line %d: %s\n",
+            locLine(cc,LOC),message);
+  outStr(cc->listing,"Current token: ");
+  printToken(cc,cc->tokKind[cc->curTok],tokenText(cc,cc->curTok));
+  cc->Error = TRUE;
   return 0;
 }
 
-/* yylex calls getToken to make Yacc/Bison output
- * compatible with ealier versions of the TINY scanner
+/* yylex hands the parser the index of the next token
+ * in the token buffer: with PreTokenize the buffer was
+ * filled before parsing, otherwise yylex calls
+ * getToken and appends to it
  */
-static int yylex(void)
-{ 
-  int token = getToken(); 
-  while (token == C_COMMENT)
-    token = getToken();
-  return token;
+static int yylex( YYSTYPE * lvalp, Compiler * cc )
+{ if (cc->PreTokenize)
+  { cc->curTok = cc->nextTok;
+    if (cc->nextTok < cc->tokCount-1) cc->nextTok++;
+  }
+  else
+  { int token = getToken(cc); 
+    while (token == C_COMMENT)
+      token = getToken(cc);
+    cc->curTok = tokAppend(cc,token,cc->tokenOffset,cc->tokenLength);
+  }
+  lvalp->tok = cc->curTok;
+  return cc->tokKind[cc->curTok];
 }
 
-TreeNode * parse(void)
-{ yyparse();
-  return savedTree;
+TreeNode * parse( Compiler * cc )
+{ if (cc->PreTokenize)
+  { if (cc->LexThreads > 1) scanParallel(cc,cc->LexThreads);
+    else scanAll(cc);
+  }
+  if (cc->RDParse) return rdParse(cc);
+  yyparse(cc);
+  return cc->savedTree;
 }
 